@@ -0,0 +1,91 @@
+#include "Protocol.h"
+
+// ============================================================================
+// ENCODING
+// ============================================================================
+
+void encodeFrame(std::string& out, Opcode opcode, std::string_view payload) {
+    uint32_t length = static_cast<uint32_t>(payload.size());
+
+    char header[FRAME_HEADER_SIZE];
+    header[0] = static_cast<char>((length >> 24) & 0xFF);
+    header[1] = static_cast<char>((length >> 16) & 0xFF);
+    header[2] = static_cast<char>((length >> 8) & 0xFF);
+    header[3] = static_cast<char>(length & 0xFF);
+    header[4] = static_cast<char>(PROTOCOL_VERSION);
+    header[5] = static_cast<char>(opcode);
+
+    out.append(header, FRAME_HEADER_SIZE);
+    out.append(payload.data(), payload.size());
+}
+
+std::string encodeFrame(Opcode opcode, std::string_view payload) {
+    std::string out;
+    out.reserve(FRAME_HEADER_SIZE + payload.size());
+    encodeFrame(out, opcode, payload);
+    return out;
+}
+
+// ============================================================================
+// DECODING
+// ============================================================================
+
+FrameDecoder::FrameDecoder()
+    : m_readOffset(0) {
+}
+
+void FrameDecoder::feed(const char* data, size_t length) {
+    // Drop consumed bytes so the buffer only holds the partial tail
+    if (m_readOffset > 0) {
+        m_buffer.erase(0, m_readOffset);
+        m_readOffset = 0;
+    }
+    m_buffer.append(data, length);
+}
+
+bool FrameDecoder::next(Frame& frame) {
+    if (!m_error.empty()) {
+        return false;
+    }
+
+    size_t available = m_buffer.size() - m_readOffset;
+    if (available < FRAME_HEADER_SIZE) {
+        return false;
+    }
+
+    const unsigned char* header =
+        reinterpret_cast<const unsigned char*>(m_buffer.data() + m_readOffset);
+
+    uint32_t length = (static_cast<uint32_t>(header[0]) << 24) |
+        (static_cast<uint32_t>(header[1]) << 16) |
+        (static_cast<uint32_t>(header[2]) << 8) |
+        static_cast<uint32_t>(header[3]);
+
+    if (header[4] != PROTOCOL_VERSION) {
+        m_error = "unsupported protocol version " + std::to_string(header[4]);
+        return false;
+    }
+
+    if (length > MAX_FRAME_PAYLOAD) {
+        m_error = "frame of " + std::to_string(length) + " bytes exceeds limit";
+        return false;
+    }
+
+    if (available < FRAME_HEADER_SIZE + length) {
+        return false;
+    }
+
+    frame.opcode = static_cast<Opcode>(header[5]);
+    frame.payload = std::string_view(
+        m_buffer.data() + m_readOffset + FRAME_HEADER_SIZE, length);
+    m_readOffset += FRAME_HEADER_SIZE + length;
+    return true;
+}
+
+bool FrameDecoder::hasError() const {
+    return !m_error.empty();
+}
+
+const std::string& FrameDecoder::getError() const {
+    return m_error;
+}
\ No newline at end of file
@@ -22,6 +22,7 @@ void displayMenu() {
     cout << "  /JOIN <room_id> <pass>   - Join a private room" << endl;
     cout << "  /LIST                    - List all active rooms" << endl;
     cout << "  /USERS                   - List users in current room" << endl;
+    cout << "  /HISTORY [id] [count]    - Show messages older than id" << endl;
     cout << "  /LEAVE                   - Leave current room" << endl;
     cout << "\n  OWNER ONLY COMMANDS:" << endl;
     cout << "  /GETPASSWORD             - View room password" << endl;
@@ -1,5 +1,6 @@
 #include "Utils.h"
 #include <iostream>
+#include <ctime>
 #include <WinSock2.h>
 #include <windows.h>
 
@@ -22,6 +23,26 @@ string trim(const string& str) {
     return str.substr(first, (last - first + 1));
 }
 
+string localizeTimestamp(const string& message) {
+    if (message.compare(0, 2, "[@") != 0) {
+        return message;
+    }
+
+    size_t close = message.find(']');
+    if (close == string::npos || close == 2 || close > 20 ||
+        message.find_first_not_of("0123456789", 2) != close) {
+        return message;
+    }
+
+    time_t seconds = static_cast<time_t>(stoll(message.substr(2, close - 2)) / 1000);
+    tm localTm;
+    localtime_s(&localTm, &seconds);
+
+    char buffer[16];
+    strftime(buffer, sizeof(buffer), "[%H:%M:%S]", &localTm);
+    return buffer + message.substr(close + 1);
+}
+
 int getConsoleWidth() {
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     int columns = 80; // default
@@ -4,5 +4,10 @@
 
 bool initializeWinsock();
 std::string trim(const std::string& str);
+
+// Rewrites a leading "[@<epoch ms>]" stamp (server started with
+// --timestamps=epoch-ms) as "[HH:MM:SS]" in local time; other messages
+// are returned unchanged
+std::string localizeTimestamp(const std::string& message);
 int getConsoleWidth();
 void printAlignedMessage(const std::string& message, bool alignRight);
\ No newline at end of file
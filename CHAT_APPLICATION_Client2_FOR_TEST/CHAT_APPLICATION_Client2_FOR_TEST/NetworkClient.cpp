@@ -2,6 +2,7 @@
 #include "ClientState.h" // Include the full definition for use
 #include "UI.h"
 #include "Utils.h"
+#include "Protocol.h"
 
 #include <iostream>
 #include <WS2tcpip.h>
@@ -18,6 +19,33 @@ using namespace std;
 // MESSAGE SENDING
 // ============================================================================
 
+// Sends one frame, retrying until the whole buffer has been written
+static bool sendFrame(SOCKET serverSocket, Opcode opcode, const string& payload) {
+    string frame = encodeFrame(opcode, payload);
+    size_t totalSent = 0;
+
+    while (totalSent < frame.size()) {
+        int result = send(serverSocket, frame.data() + totalSent,
+            static_cast<int>(frame.size() - totalSent), 0);
+        if (result == SOCKET_ERROR) {
+            return false;
+        }
+        totalSent += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+// Wraps a line typed by the user in the matching frame type
+static bool sendUserInput(SOCKET serverSocket, const string& message) {
+    if (message[0] == '/') {
+        return sendFrame(serverSocket, Opcode::Command, message.substr(1));
+    }
+    if (message[0] == '@') {
+        return sendFrame(serverSocket, Opcode::PrivateMessage, message.substr(1));
+    }
+    return sendFrame(serverSocket, Opcode::Chat, message);
+}
+
 void sendMessageToServer(SOCKET serverSocket, ClientState& state) {
     // Get username
     bool nameAccepted = false;
@@ -36,10 +64,7 @@ void sendMessageToServer(SOCKET serverSocket, ClientState& state) {
         state.setUsername(username);
 
         // Send username to server
-        string nameCmd = "/SETNAME " + username;
-        int result = send(serverSocket, nameCmd.c_str(), static_cast<int>(nameCmd.length()), 0);
-
-        if (result == SOCKET_ERROR) {
+        if (!sendFrame(serverSocket, Opcode::Command, "SETNAME " + username)) {
             cout << "[ERROR] Failed to set username" << endl;
             state.setShouldExit(true);
             return;
@@ -256,6 +281,12 @@ void sendMessageToServer(SOCKET serverSocket, ClientState& state) {
             else if (cmd == "GETPASSWORD") {
                 // Pass through to server
             }
+            else if (cmd == "HISTORY") {
+                if (!state.isInRoom()) {
+                    cout << "[ERROR] You must be in a room to view history" << endl;
+                    continue;
+                }
+            }
             else {
                 cout << "[ERROR] Unknown command. Type /HELP for available commands." << endl;
                 continue;
@@ -274,9 +305,7 @@ void sendMessageToServer(SOCKET serverSocket, ClientState& state) {
         }
 
         // Send message to server
-        int bytesSent = send(serverSocket, message.c_str(), static_cast<int>(message.length()), 0);
-
-        if (bytesSent == SOCKET_ERROR) {
+        if (!sendUserInput(serverSocket, message)) {
             cout << "[ERROR] Failed to send message: " << WSAGetLastError() << endl;
             state.setShouldExit(true);
             break;
@@ -292,11 +321,11 @@ void sendMessageToServer(SOCKET serverSocket, ClientState& state) {
 void receiveMessages(SOCKET serverSocket, ClientState& state) {
     const int BUFFER_SIZE = 4096;
     char buffer[BUFFER_SIZE];
-    string incompleteMessage = "";
+    FrameDecoder decoder;
     bool inMessageHistory = false;
 
     while (!state.shouldExit()) {
-        int bytesReceived = recv(serverSocket, buffer, BUFFER_SIZE - 1, 0);
+        int bytesReceived = recv(serverSocket, buffer, BUFFER_SIZE, 0);
 
         if (bytesReceived <= 0) {
             if (bytesReceived == 0) {
@@ -314,15 +343,15 @@ void receiveMessages(SOCKET serverSocket, ClientState& state) {
             break;
         }
 
-        buffer[bytesReceived] = '\0';
-        string receivedData = incompleteMessage + string(buffer, bytesReceived);
+        decoder.feed(buffer, static_cast<size_t>(bytesReceived));
 
-        size_t pos = 0;
-        size_t newlinePos;
+        Frame frame;
+        while (decoder.next(frame)) {
+            if (frame.opcode != Opcode::ServerText) {
+                continue;
+            }
 
-        while ((newlinePos = receivedData.find('\n', pos)) != string::npos) {
-            string message = receivedData.substr(pos, newlinePos - pos);
-            message = trim(message);
+            string message = localizeTimestamp(trim(string(frame.payload)));
 
             if (!message.empty()) {
                 // Parse server responses
@@ -361,6 +390,22 @@ void receiveMessages(SOCKET serverSocket, ClientState& state) {
                     inMessageHistory = false;
                     cout << "--- End of History ---\n" << endl;
                 }
+                else if (message.find("HISTORY_PAGE_START:") == 0) {
+                    inMessageHistory = true;
+                    cout << "\n--- Older Messages ---" << endl;
+                }
+                else if (message.find("HISTORY_PAGE_END:") == 0) {
+                    // Carries the cursor for the next older page, 0 if none
+                    inMessageHistory = false;
+                    string nextBeforeId = trim(message.substr(17));
+                    if (nextBeforeId == "0") {
+                        cout << "--- Beginning of Room History ---\n" << endl;
+                    }
+                    else {
+                        cout << "--- Type /HISTORY " << nextBeforeId
+                            << " for earlier messages ---\n" << endl;
+                    }
+                }
                 else if (message.find("ROOM_NOT_FOUND") == 0) {
                     cout << "\n[X] Error: Room not found! Please check the room ID." << endl;
                     cout << "Use /LIST to see available rooms or /CREATE to make a new one.\n" << endl;
@@ -466,6 +511,12 @@ void receiveMessages(SOCKET serverSocket, ClientState& state) {
                 else if (message.find("ERROR:") == 0) {
                     cout << "\n" << message << "\n" << endl;
                 }
+                else if (message.find("RATE_LIMITED:") == 0) {
+                    // Sent once per run of dropped messages
+                    string scope = message.substr(13);
+                    cout << "\n[!] Slow down: " << (scope == "room" ? "this room is" : "you are")
+                        << " sending too fast, messages are being dropped\n" << endl;
+                }
                 else if (message.find("SYSTEM:") == 0) {
                     // System messages (user joined/left)
                     if (state.isInRoom() || inMessageHistory) {
@@ -479,16 +530,12 @@ void receiveMessages(SOCKET serverSocket, ClientState& state) {
                     }
                 }
             }
-
-            pos = newlinePos + 1;
         }
 
-        // Save incomplete message for next iteration
-        if (pos < receivedData.length()) {
-            incompleteMessage = receivedData.substr(pos);
-        }
-        else {
-            incompleteMessage = "";
+        if (decoder.hasError()) {
+            cout << "\n[ERROR] Protocol error: " << decoder.getError() << endl;
+            state.setShouldExit(true);
+            break;
         }
     }
 }
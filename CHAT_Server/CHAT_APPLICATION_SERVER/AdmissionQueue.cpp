@@ -0,0 +1,116 @@
+#include "AdmissionQueue.h"
+#include "Globals.h"
+#include "Config.h"
+#include "Utilities.h"
+#include "Metrics.h"
+#include "Logger.h"
+
+AdmissionQueue::AdmissionQueue(SOCKET listenSocket, double ratePerSecond, double burst)
+    : m_listenSocket(listenSocket)
+    , m_backlogDrained(true)
+    , m_accepted(0)
+    , m_refused(0)
+    , m_peakWaiting(0) {
+    if (ratePerSecond > 0.0) {
+        m_bucket = make_unique<TokenBucket>(ratePerSecond, max(1.0, burst));
+    }
+}
+
+AdmissionQueue::~AdmissionQueue() {
+    closeWaiting();
+}
+
+void AdmissionQueue::acceptAll() {
+    m_backlogDrained = false;
+
+    while (true) {
+#ifdef __linux__
+        SOCKET clientSocket = accept4(m_listenSocket, nullptr, nullptr,
+            SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+        SOCKET clientSocket = accept(m_listenSocket, nullptr, nullptr);
+#endif
+        if (clientSocket == INVALID_SOCKET) {
+            int error = WSAGetLastError();
+            if (error == WSAEWOULDBLOCK) {
+                m_backlogDrained = true;
+            }
+#ifndef _WIN32
+            else if (error == EINTR || error == ECONNABORTED) {
+                // The peer gave up while queued; keep draining
+                continue;
+            }
+#endif
+            else {
+                LOG_ERROR("[ERROR] accept failed: " << error);
+            }
+            break;
+        }
+
+#ifndef __linux__
+        setSocketNonBlocking(clientSocket);
+#endif
+
+        // Reserve the slot now; Reactor::closeConnection releases it
+        if (g_activeConnections.fetch_add(1) >= g_config.maxConnections) {
+            g_activeConnections--;
+            refuse(clientSocket);
+            continue;
+        }
+
+        m_accepted++;
+        g_serverMetrics.connectionsAccepted.add();
+        m_waiting.push_back(clientSocket);
+        m_peakWaiting = max(m_peakWaiting, m_waiting.size());
+    }
+}
+
+bool AdmissionQueue::needsAccept() const {
+    return !m_backlogDrained;
+}
+
+// Tells the client why before closing, so it doesn't retry blindly
+void AdmissionQueue::refuse(SOCKET clientSocket) {
+    static const SharedPayload s_serverFull = makeServerTextPayload("ERROR: Server is full\n");
+
+    // A brand-new socket has an empty send buffer; one small frame fits
+    send(clientSocket, s_serverFull->data(), static_cast<int>(s_serverFull->size()), 0);
+    closesocket(clientSocket);
+    m_refused++;
+    g_serverMetrics.connectionsRefused.add();
+}
+
+int AdmissionQueue::nextTimeoutMs(int defaultMs) {
+    if (!m_backlogDrained) {
+        // Retry a failed accept soon, but don't spin on EMFILE
+        return min(defaultMs, 10);
+    }
+    if (m_waiting.empty() || !m_bucket) {
+        return defaultMs;
+    }
+    return static_cast<int>(min<long long>(defaultMs, m_bucket->timeUntilNext().count()));
+}
+
+void AdmissionQueue::closeWaiting() {
+    for (SOCKET clientSocket : m_waiting) {
+        closesocket(clientSocket);
+        g_activeConnections--;
+    }
+    m_waiting.clear();
+}
+
+size_t AdmissionQueue::getWaiting() const {
+    return m_waiting.size();
+}
+
+size_t AdmissionQueue::getPeakWaiting() const {
+    return m_peakWaiting;
+}
+
+uint64_t AdmissionQueue::getAccepted() const {
+    return m_accepted;
+}
+
+uint64_t AdmissionQueue::getRefused() const {
+    return m_refused;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include "Common.h"
+#include "TokenBucket.h"
+#include <deque>
+
+// Accept path for one listening socket: the main acceptor thread, or each
+// reactor in reuseport mode. Built for reconnect storms, when every client
+// comes back at once after a restart.
+//
+// acceptAll() drains the whole kernel backlog per wakeup (accept4 on
+// Linux, so sockets arrive non-blocking without extra syscalls). Sockets
+// beyond --max-connections are refused straight away; the rest wait in a
+// FIFO and are released by admit() at --accept-rate per second, so the
+// reactors register clients and send WELCOME at a pace they can sustain
+// instead of all at once.
+class AdmissionQueue {
+private:
+    SOCKET m_listenSocket;
+    unique_ptr<TokenBucket> m_bucket;   // Null when the rate is unlimited
+    deque<SOCKET> m_waiting;
+    bool m_backlogDrained;
+
+    uint64_t m_accepted;
+    uint64_t m_refused;
+    size_t m_peakWaiting;
+
+    void refuse(SOCKET clientSocket);
+
+public:
+    // ratePerSecond 0 admits as fast as sockets are accepted
+    AdmissionQueue(SOCKET listenSocket, double ratePerSecond, double burst);
+    ~AdmissionQueue();
+
+    AdmissionQueue(const AdmissionQueue&) = delete;
+    AdmissionQueue& operator=(const AdmissionQueue&) = delete;
+
+    // Accepts until the backlog is empty or accept() fails. A failure
+    // such as EMFILE leaves the backlog non-empty; since edge-triggered
+    // loops won't report it again, retry on the next wakeup when
+    // needsAccept() says so.
+    void acceptAll();
+    bool needsAccept() const;
+
+    // Hands queued sockets to onAdmit(SOCKET) while tokens last
+    template <typename Fn>
+    void admit(Fn&& onAdmit) {
+        while (!m_waiting.empty() && (!m_bucket || m_bucket->tryTake())) {
+            SOCKET clientSocket = m_waiting.front();
+            m_waiting.pop_front();
+            onAdmit(clientSocket);
+        }
+    }
+
+    // Event-loop timeout that wakes in time for the next token while
+    // sockets are waiting; defaultMs otherwise
+    int nextTimeoutMs(int defaultMs);
+
+    // Closes sockets that were never admitted (shutdown)
+    void closeWaiting();
+
+    size_t getWaiting() const;
+    size_t getPeakWaiting() const;
+    uint64_t getAccepted() const;
+    uint64_t getRefused() const;
+};
\ No newline at end of file
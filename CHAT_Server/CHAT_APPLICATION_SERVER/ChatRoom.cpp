@@ -1,42 +1,55 @@
 #include "ChatRoom.h"
+#include "Utilities.h"
+#include "Config.h"
+#include "Logger.h"
 
-ChatRoom::ChatRoom(const string& id, bool isPrivate, const string& password, SOCKET owner)
-    : m_roomId(id)
+ChatRoom::ChatRoom(SymbolRef id, bool isPrivate, const string& password, SOCKET owner)
+    : m_roomId(move(id))
     , m_password(password)
     , m_isPrivate(isPrivate)
-    , m_ownerSocket(owner) {
-    cout << "[ROOM] Created " << (isPrivate ? "private" : "public")
-        << " room: " << m_roomId << endl;
+    , m_ownerSocket(owner)
+    , m_joinHead(NO_SLOT)
+    , m_joinTail(NO_SLOT)
+    , m_freeHead(NO_SLOT)
+    , m_memberCount(0)
+    , m_historyRing(MAX_MESSAGE_HISTORY)
+    , m_historyStart(0)
+    , m_historyCount(0)
+    , m_historyHydrated(false)
+    , m_rateLimiter(g_config.roomMsgRate, g_config.roomByteRate)
+    , m_roomMutex(LockRank::Room) {
+    LOG_INFO("[ROOM] Created " << (isPrivate ? "private" : "public")
+        << " room: " << m_roomId);
 }
 
 ChatRoom::~ChatRoom() {
-    cout << "[ROOM] Destroyed room: " << m_roomId << endl;
+    LOG_INFO("[ROOM] Destroyed room: " << m_roomId);
 }
 
 // Room information getters
-string ChatRoom::getRoomId() const {
-    lock_guard<mutex> lock(m_roomMutex);
+Symbol ChatRoom::getRoomId() const {
+    lock_guard<RankedMutex> lock(m_roomMutex);
     return m_roomId;
 }
 
 bool ChatRoom::getIsPrivate() const {
-    lock_guard<mutex> lock(m_roomMutex);
+    lock_guard<RankedMutex> lock(m_roomMutex);
     return m_isPrivate;
 }
 
 string ChatRoom::getPassword() const {
-    lock_guard<mutex> lock(m_roomMutex);
+    lock_guard<RankedMutex> lock(m_roomMutex);
     return m_password;
 }
 
 SOCKET ChatRoom::getOwner() const {
-    lock_guard<mutex> lock(m_roomMutex);
+    lock_guard<RankedMutex> lock(m_roomMutex);
     return m_ownerSocket;
 }
 
 int ChatRoom::getClientCount() const {
-    lock_guard<mutex> lock(m_roomMutex);
-    return static_cast<int>(m_clients.size());
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    return static_cast<int>(m_memberCount);
 }
 
 bool ChatRoom::isEmpty() const {
@@ -45,126 +58,275 @@ bool ChatRoom::isEmpty() const {
 
 // Password management
 bool ChatRoom::verifyPassword(const string& password) const {
-    lock_guard<mutex> lock(m_roomMutex);
+    lock_guard<RankedMutex> lock(m_roomMutex);
     return m_password == password;
 }
 
 void ChatRoom::setPassword(const string& newPassword) {
-    lock_guard<mutex> lock(m_roomMutex);
+    lock_guard<RankedMutex> lock(m_roomMutex);
     m_password = newPassword;
-    cout << "[ROOM:" << m_roomId << "] Password changed" << endl;
+    LOG_INFO("[ROOM:" << m_roomId << "] Password changed");
 }
 
 // Ownership management
 void ChatRoom::setOwner(SOCKET newOwner) {
-    lock_guard<mutex> lock(m_roomMutex);
+    lock_guard<RankedMutex> lock(m_roomMutex);
     m_ownerSocket = newOwner;
-    cout << "[ROOM:" << m_roomId << "] Ownership transferred to client "
-        << newOwner << endl;
+    LOG_INFO("[ROOM:" << m_roomId << "] Ownership transferred to client "
+        << newOwner);
 }
 
 // Ban management
-bool ChatRoom::isUserBanned(const string& username) const {
-    lock_guard<mutex> lock(m_roomMutex);
+bool ChatRoom::isUserBanned(Symbol username) const {
+    lock_guard<RankedMutex> lock(m_roomMutex);
     return m_bannedUsers.find(username) != m_bannedUsers.end();
 }
 
-void ChatRoom::banUser(const string& username) {
-    lock_guard<mutex> lock(m_roomMutex);
-    m_bannedUsers.insert(username);
-    cout << "[ROOM:" << m_roomId << "] User banned: " << username << endl;
+void ChatRoom::banUser(const SymbolRef& username) {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    m_bannedUsers.emplace(username, username);
+    LOG_INFO("[ROOM:" << m_roomId << "] User banned: " << username);
+}
+
+// Membership helpers
+uint32_t ChatRoom::takeSlot() {
+    uint32_t slot = m_freeHead;
+    if (slot != NO_SLOT) {
+        m_freeHead = m_joinNext[slot];
+    }
+    else {
+        slot = static_cast<uint32_t>(m_memberSockets.size());
+        m_memberSockets.push_back(INVALID_SOCKET);
+        m_memberConnections.emplace_back();
+        m_memberNames.emplace_back();
+        m_joinPrev.push_back(NO_SLOT);
+        m_joinNext.push_back(NO_SLOT);
+    }
+
+    // Append to the join-order list
+    m_joinPrev[slot] = m_joinTail;
+    m_joinNext[slot] = NO_SLOT;
+    if (m_joinTail != NO_SLOT) {
+        m_joinNext[m_joinTail] = slot;
+    }
+    else {
+        m_joinHead = slot;
+    }
+    m_joinTail = slot;
+    m_memberCount++;
+    return slot;
+}
+
+void ChatRoom::releaseSlot(uint32_t slot) {
+    // Unlink from the join-order list
+    uint32_t prev = m_joinPrev[slot];
+    uint32_t next = m_joinNext[slot];
+    if (prev != NO_SLOT) {
+        m_joinNext[prev] = next;
+    }
+    else {
+        m_joinHead = next;
+    }
+    if (next != NO_SLOT) {
+        m_joinPrev[next] = prev;
+    }
+    else {
+        m_joinTail = prev;
+    }
+
+    m_memberSockets[slot] = INVALID_SOCKET;
+    m_memberConnections[slot].reset();
+    m_memberNames[slot] = SymbolRef();
+    m_memberCount--;
+
+    // An empty room gives its slots back instead of keeping the holes
+    if (m_memberCount == 0) {
+        m_memberSockets.clear();
+        m_memberConnections.clear();
+        m_memberNames.clear();
+        m_joinPrev.clear();
+        m_joinNext.clear();
+        m_joinHead = m_joinTail = m_freeHead = NO_SLOT;
+        return;
+    }
+
+    m_joinNext[slot] = m_freeHead;
+    m_freeHead = slot;
+}
+
+void ChatRoom::indexName(uint32_t slot, const SymbolRef& username) {
+    m_memberNames[slot] = username;
+    if (!username.empty()) {
+        m_slotByName[username] = slot;
+    }
+}
+
+void ChatRoom::unindexName(uint32_t slot) {
+    auto it = m_slotByName.find(m_memberNames[slot]);
+    if (it != m_slotByName.end() && it->second == slot) {
+        m_slotByName.erase(it);
+    }
+    m_memberNames[slot] = SymbolRef();
 }
 
 // Client management
-void ChatRoom::addClient(SOCKET clientSocket) {
-    lock_guard<mutex> lock(m_roomMutex);
-    m_clients.insert(clientSocket);
-    m_clientJoinTimes[clientSocket] = chrono::steady_clock::now();
-    cout << "[ROOM:" << m_roomId << "] Client " << clientSocket
-        << " added. Total: " << m_clients.size() << endl;
+void ChatRoom::addClient(SOCKET clientSocket, const SymbolRef& username,
+    shared_ptr<Connection> connection) {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    auto it = m_slotBySocket.find(clientSocket);
+    if (it != m_slotBySocket.end()) {
+        m_memberConnections[it->second] = move(connection);
+        unindexName(it->second);
+        indexName(it->second, username);
+        return;
+    }
+
+    uint32_t slot = takeSlot();
+    m_memberSockets[slot] = clientSocket;
+    m_memberConnections[slot] = move(connection);
+    indexName(slot, username);
+    m_slotBySocket.emplace(clientSocket, slot);
+    LOG_INFO("[ROOM:" << m_roomId << "] Client " << clientSocket
+        << " added. Total: " << m_memberCount);
 }
 
 void ChatRoom::removeClient(SOCKET clientSocket) {
-    lock_guard<mutex> lock(m_roomMutex);
-    m_clients.erase(clientSocket);
-    m_clientJoinTimes.erase(clientSocket);
-    cout << "[ROOM:" << m_roomId << "] Client " << clientSocket
-        << " removed. Remaining: " << m_clients.size() << endl;
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    auto it = m_slotBySocket.find(clientSocket);
+    if (it != m_slotBySocket.end()) {
+        uint32_t slot = it->second;
+        m_slotBySocket.erase(it);
+        unindexName(slot);
+        releaseSlot(slot);
+    }
+    LOG_INFO("[ROOM:" << m_roomId << "] Client " << clientSocket
+        << " removed. Remaining: " << m_memberCount);
+}
+
+void ChatRoom::renameClient(SOCKET clientSocket, const SymbolRef& newUsername) {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    auto it = m_slotBySocket.find(clientSocket);
+    if (it == m_slotBySocket.end()) {
+        return;
+    }
+
+    unindexName(it->second);
+    indexName(it->second, newUsername);
 }
 
 bool ChatRoom::hasClient(SOCKET clientSocket) const {
-    lock_guard<mutex> lock(m_roomMutex);
-    return m_clients.find(clientSocket) != m_clients.end();
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    return m_slotBySocket.find(clientSocket) != m_slotBySocket.end();
 }
 
-set<SOCKET> ChatRoom::getClients() const {
-    lock_guard<mutex> lock(m_roomMutex);
-    return m_clients;
+SOCKET ChatRoom::findMemberByName(Symbol username) const {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    auto it = m_slotByName.find(username);
+    return (it != m_slotByName.end()) ? m_memberSockets[it->second] : INVALID_SOCKET;
 }
 
-SOCKET ChatRoom::getLongestMember() const {
-    lock_guard<mutex> lock(m_roomMutex);
+vector<SymbolRef> ChatRoom::getMemberNames() const {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    vector<SymbolRef> names;
+    names.reserve(m_memberCount);
+    for (uint32_t slot = m_joinHead; slot != NO_SLOT; slot = m_joinNext[slot]) {
+        if (!m_memberNames[slot].empty()) {
+            names.push_back(m_memberNames[slot]);
+        }
+    }
+    return names;
+}
 
-    if (m_clients.empty()) {
-        return INVALID_SOCKET;
+SOCKET ChatRoom::getLongestMember(SOCKET excludeSocket) const {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    for (uint32_t slot = m_joinHead; slot != NO_SLOT; slot = m_joinNext[slot]) {
+        if (m_memberSockets[slot] != excludeSocket) {
+            return m_memberSockets[slot];
+        }
     }
+    return INVALID_SOCKET;
+}
 
-    SOCKET longestMember = INVALID_SOCKET;
-    chrono::steady_clock::time_point earliestTime = chrono::steady_clock::now();
+void ChatRoom::getRecipients(SOCKET senderSocket,
+    vector<shared_ptr<Connection>>& recipients) const {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    recipients.clear();
+    recipients.reserve(m_memberCount);
 
-    for (SOCKET sock : m_clients) {
-        auto it = m_clientJoinTimes.find(sock);
-        if (it != m_clientJoinTimes.end()) {
-            if (longestMember == INVALID_SOCKET || it->second < earliestTime) {
-                earliestTime = it->second;
-                longestMember = sock;
-            }
+    // Free slots have no connection, and neither does a member whose
+    // client was already gone when it joined
+    for (size_t slot = 0; slot < m_memberSockets.size(); slot++) {
+        if (m_memberSockets[slot] != senderSocket && m_memberConnections[slot]) {
+            recipients.push_back(m_memberConnections[slot]);
         }
     }
-
-    return longestMember;
 }
 
 // Message history management
-void ChatRoom::addMessageToHistory(const string& message) {
-    lock_guard<mutex> lock(m_roomMutex);
-    m_messageHistory.push_back(message);
+void ChatRoom::addMessageToHistory(const SharedPayload& payload) {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    size_t capacity = m_historyRing.size();
+
+    // Once full, the new message overwrites the oldest one
+    m_historyRing[(m_historyStart + m_historyCount) % capacity] = payload;
+    if (m_historyCount < capacity) {
+        m_historyCount++;
+    }
+    else {
+        m_historyStart = (m_historyStart + 1) % capacity;
+    }
+}
+
+vector<SharedPayload> ChatRoom::getMessageHistory() const {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    vector<SharedPayload> history;
+    history.reserve(m_historyCount);
 
-    if (m_messageHistory.size() > MAX_MESSAGE_HISTORY) {
-        m_messageHistory.erase(m_messageHistory.begin());
+    for (size_t i = 0; i < m_historyCount; i++) {
+        history.push_back(m_historyRing[(m_historyStart + i) % m_historyRing.size()]);
     }
+    return history;
 }
 
-vector<string> ChatRoom::getMessageHistory() const {
-    lock_guard<mutex> lock(m_roomMutex);
-    return m_messageHistory;
+bool ChatRoom::needsHistoryHydration() const {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    return !m_historyHydrated && m_historyCount == 0;
+}
+
+void ChatRoom::hydrateHistory(const vector<SharedPayload>& storedMessages) {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    if (m_historyHydrated || m_historyCount > 0) {
+        m_historyHydrated = true;
+        return;
+    }
+
+    // Keep the newest messages if more were loaded than fit
+    size_t skip = storedMessages.size() > m_historyRing.size() ?
+        storedMessages.size() - m_historyRing.size() : 0;
+    for (size_t i = skip; i < storedMessages.size(); i++) {
+        m_historyRing[m_historyCount++] = storedMessages[i];
+    }
+    m_historyStart = 0;
+    m_historyHydrated = true;
+}
+
+// Flood control
+bool ChatRoom::admitMessage(size_t bytes) {
+    lock_guard<RankedMutex> lock(m_roomMutex);
+    return m_rateLimiter.admit(bytes);
 }
 
 // Broadcasting methods
 void ChatRoom::broadcast(const string& message, SOCKET senderSocket) {
-    lock_guard<mutex> lock(m_roomMutex);
-
-    for (SOCKET clientSocket : m_clients) {
-        if (clientSocket != senderSocket && clientSocket != INVALID_SOCKET) {
-            int result = send(clientSocket, message.c_str(),
-                static_cast<int>(message.length()), 0);
-            if (result == SOCKET_ERROR) {
-                cout << "[ERROR] Failed to send to client " << clientSocket << endl;
-            }
-        }
-    }
+    broadcast(makeServerTextPayload(message), senderSocket);
+}
+
+void ChatRoom::broadcast(const SharedPayload& payload, SOCKET senderSocket) {
+    vector<shared_ptr<Connection>> recipients;
+    getRecipients(senderSocket, recipients);
+    sendToClients(recipients, payload);
 }
 
 void ChatRoom::broadcastToAll(const string& message) {
-    lock_guard<mutex> lock(m_roomMutex);
-
-    for (SOCKET clientSocket : m_clients) {
-        if (clientSocket != INVALID_SOCKET) {
-            int result = send(clientSocket, message.c_str(),
-                static_cast<int>(message.length()), 0);
-            if (result == SOCKET_ERROR) {
-                cout << "[ERROR] Failed to send to client " << clientSocket << endl;
-            }
-        }
-    }
+    broadcast(message, INVALID_SOCKET);
 }
\ No newline at end of file
@@ -1,24 +1,67 @@
 #pragma once
 #include "Common.h"
+#include "Connection.h"
+#include "LockOrder.h"
+#include "RateLimiter.h"
+#include "SymbolTable.h"
+#include <unordered_map>
 
 class ChatRoom {
 private:
-    string m_roomId;
+    SymbolRef m_roomId;
     string m_password;
     bool m_isPrivate;
     SOCKET m_ownerSocket;
-    set<SOCKET> m_clients;
-    set<string> m_bannedUsers;
-    vector<string> m_messageHistory;
-    map<SOCKET, chrono::steady_clock::time_point> m_clientJoinTimes;
-    mutable mutex m_roomMutex;
+
+    // Banned names; the SymbolRef keeps each one interned while it is banned
+    unordered_map<Symbol, SymbolRef> m_bannedUsers;
+
+    // Members as parallel arrays indexed by slot. A member keeps its slot
+    // from join to leave, freed slots hold INVALID_SOCKET and no
+    // connection until they are reused, and fan-out is one pass over
+    // m_memberConnections. Occupied slots are also linked in join order,
+    // so the longest-standing member is the head of the list; m_joinNext
+    // chains the free slots as well.
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+    vector<SOCKET> m_memberSockets;
+    vector<shared_ptr<Connection>> m_memberConnections;
+    vector<SymbolRef> m_memberNames;
+    vector<uint32_t> m_joinPrev;
+    vector<uint32_t> m_joinNext;
+    uint32_t m_joinHead;
+    uint32_t m_joinTail;
+    uint32_t m_freeHead;
+    size_t m_memberCount;
+
+    // Socket and username -> slot, so PM routing, KICK/BAN/TRANSFER and
+    // leaving are constant-time. Names are keyed by the Symbols held in
+    // m_memberNames.
+    unordered_map<SOCKET, uint32_t> m_slotBySocket;
+    unordered_map<Symbol, uint32_t> m_slotByName;
+
+    // Last MAX_MESSAGE_HISTORY broadcasts as encoded frames, in a fixed
+    // ring: m_historyCount entries starting at m_historyStart
+    vector<SharedPayload> m_historyRing;
+    size_t m_historyStart;
+    size_t m_historyCount;
+    bool m_historyHydrated;
+
+    // Room-wide flood limit (--room-rate/--room-bytes), shared by all members
+    RateLimiter m_rateLimiter;
+    mutable RankedMutex m_roomMutex;
+
+    // Membership helpers; m_roomMutex must be held
+    uint32_t takeSlot();
+    void releaseSlot(uint32_t slot);
+    void indexName(uint32_t slot, const SymbolRef& username);
+    void unindexName(uint32_t slot);
 
 public:
-    ChatRoom(const string& id, bool isPrivate, const string& password, SOCKET owner);
+    ChatRoom(SymbolRef id, bool isPrivate, const string& password, SOCKET owner);
     ~ChatRoom();
 
     // Room information getters
-    string getRoomId() const;
+    Symbol getRoomId() const;
     bool getIsPrivate() const;
     string getPassword() const;
     SOCKET getOwner() const;
@@ -33,21 +76,49 @@ public:
     void setOwner(SOCKET newOwner);
 
     // Ban management
-    bool isUserBanned(const string& username) const;
-    void banUser(const string& username);
+    bool isUserBanned(Symbol username) const;
+    void banUser(const SymbolRef& username);
 
     // Client management
-    void addClient(SOCKET clientSocket);
+    // Re-adding a member updates its name and connection
+    void addClient(SOCKET clientSocket, const SymbolRef& username,
+        shared_ptr<Connection> connection);
     void removeClient(SOCKET clientSocket);
+    void renameClient(SOCKET clientSocket, const SymbolRef& newUsername);
     bool hasClient(SOCKET clientSocket) const;
-    set<SOCKET> getClients() const;
-    SOCKET getLongestMember() const;
+    SOCKET findMemberByName(Symbol username) const;
+
+    // Named members, in join order
+    vector<SymbolRef> getMemberNames() const;
+
+    // The member who joined first, other than excludeSocket
+    SOCKET getLongestMember(SOCKET excludeSocket = INVALID_SOCKET) const;
+
+    // Replaces recipients with the connection of every member except
+    // senderSocket. Delivering to these objects rather than to socket
+    // numbers means a descriptor closed and reused meanwhile can't pick
+    // up the room's traffic.
+    void getRecipients(SOCKET senderSocket,
+        vector<shared_ptr<Connection>>& recipients) const;
+
+    // Message history management (stores encoded frames, shared with recipients)
+    void addMessageToHistory(const SharedPayload& payload);
+    vector<SharedPayload> getMessageHistory() const;
+
+    // True until the ring has either been loaded from the database or seen
+    // a live message; only such a cold room is worth a history query
+    bool needsHistoryHydration() const;
+
+    // Seeds an empty ring with stored messages (oldest first). Ignored if
+    // the room was hydrated meanwhile or has live messages already.
+    void hydrateHistory(const vector<SharedPayload>& storedMessages);
 
-    // Message history management
-    void addMessageToHistory(const string& message);
-    vector<string> getMessageHistory() const;
+    // Charges one message against the room's flood limit. Returns false
+    // if it must be dropped.
+    bool admitMessage(size_t bytes);
 
     // Broadcasting methods
     void broadcast(const string& message, SOCKET senderSocket);
+    void broadcast(const SharedPayload& payload, SOCKET senderSocket);
     void broadcastToAll(const string& message);
 };
\ No newline at end of file
@@ -1,31 +1,55 @@
 #include "ClientInfo.h"
+#include "Config.h"
 
 ClientInfo::ClientInfo()
     : m_socket(INVALID_SOCKET)
-    , m_username("")
-    , m_roomId("")
     , m_isRoomOwner(false)
-    , m_joinTime(chrono::steady_clock::now()) {
+    , m_joinTime(chrono::steady_clock::now())
+    , m_rateLimiter(g_config.clientMsgRate, g_config.clientByteRate)
+    , m_rateLimitNotified(false)
+    , m_notifiedBeforeAdmit(false) {
 }
 
 ClientInfo::ClientInfo(SOCKET socket)
     : m_socket(socket)
-    , m_username("")
-    , m_roomId("")
     , m_isRoomOwner(false)
-    , m_joinTime(chrono::steady_clock::now()) {
+    , m_joinTime(chrono::steady_clock::now())
+    , m_rateLimiter(g_config.clientMsgRate, g_config.clientByteRate)
+    , m_rateLimitNotified(false)
+    , m_notifiedBeforeAdmit(false) {
 }
 
 // Getters
 SOCKET ClientInfo::getSocket() const { return m_socket; }
-string ClientInfo::getUsername() const { return m_username; }
-string ClientInfo::getRoomId() const { return m_roomId; }
+const SymbolRef& ClientInfo::getUsername() const { return m_username; }
+const SymbolRef& ClientInfo::getRoomId() const { return m_roomId; }
 bool ClientInfo::isRoomOwner() const { return m_isRoomOwner; }
 chrono::steady_clock::time_point ClientInfo::getJoinTime() const { return m_joinTime; }
 
 // Setters
 void ClientInfo::setSocket(SOCKET socket) { m_socket = socket; }
-void ClientInfo::setUsername(const string& username) { m_username = username; }
-void ClientInfo::setRoomId(const string& roomId) { m_roomId = roomId; }
+void ClientInfo::setUsername(SymbolRef username) { m_username = move(username); }
+void ClientInfo::setRoomId(SymbolRef roomId) { m_roomId = move(roomId); }
 void ClientInfo::setIsRoomOwner(bool isOwner) { m_isRoomOwner = isOwner; }
-void ClientInfo::setJoinTime(const chrono::steady_clock::time_point& time) { m_joinTime = time; }
\ No newline at end of file
+void ClientInfo::setJoinTime(const chrono::steady_clock::time_point& time) { m_joinTime = time; }
+
+// Flood control
+bool ClientInfo::admitMessage(size_t bytes) {
+    if (!m_rateLimiter.admit(bytes)) {
+        return false;
+    }
+    m_notifiedBeforeAdmit = m_rateLimitNotified;
+    m_rateLimitNotified = false;
+    return true;
+}
+
+void ClientInfo::refundMessage(size_t bytes) {
+    m_rateLimiter.refund(bytes);
+    m_rateLimitNotified = m_notifiedBeforeAdmit;
+}
+
+bool ClientInfo::markRateLimited() {
+    bool firstDrop = !m_rateLimitNotified;
+    m_rateLimitNotified = true;
+    return firstDrop;
+}
\ No newline at end of file
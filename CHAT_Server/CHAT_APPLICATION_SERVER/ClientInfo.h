@@ -1,29 +1,50 @@
 #pragma once
 #include "Common.h"
+#include "RateLimiter.h"
+#include "SymbolTable.h"
 
 class ClientInfo {
 private:
     SOCKET m_socket;
-    string m_username;
-    string m_roomId;
+    SymbolRef m_username;
+    SymbolRef m_roomId;
     bool m_isRoomOwner;
     chrono::steady_clock::time_point m_joinTime;
 
+    // Flood control for chat and private messages (--client-rate/-bytes)
+    RateLimiter m_rateLimiter;
+    bool m_rateLimitNotified;
+    bool m_notifiedBeforeAdmit;     // Restored if the admitted message is refunded
+
 public:
     ClientInfo();
     explicit ClientInfo(SOCKET socket);
 
     // Getters
     SOCKET getSocket() const;
-    string getUsername() const;
-    string getRoomId() const;
+    const SymbolRef& getUsername() const;
+    const SymbolRef& getRoomId() const;
     bool isRoomOwner() const;
     chrono::steady_clock::time_point getJoinTime() const;
 
     // Setters
     void setSocket(SOCKET socket);
-    void setUsername(const string& username);
-    void setRoomId(const string& roomId);
+    void setUsername(SymbolRef username);
+    void setRoomId(SymbolRef roomId);
     void setIsRoomOwner(bool isOwner);
     void setJoinTime(const chrono::steady_clock::time_point& time);
+
+    // Charges one message against this client's flood limits. Returns
+    // false if it must be dropped.
+    bool admitMessage(size_t bytes);
+
+    // Gives back an admitted message's charge when the room's limit
+    // drops it, so room drops don't also use up the sender's budget. The
+    // message then counts as part of the current run of drops.
+    void refundMessage(size_t bytes);
+
+    // Records a dropped message. Returns true only for the first drop
+    // since the last admitted message, so RATE_LIMITED is sent once per
+    // run of drops rather than once per message.
+    bool markRateLimited();
 };
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "Clock.h"
+#include <cstring>
+
+CoarseClock g_clock;
+
+CoarseClock::CoarseClock()
+    : m_packedTime(0)
+    , m_running(false)
+    , m_stopping(false) {
+}
+
+CoarseClock::~CoarseClock() {
+    stop();
+}
+
+uint64_t CoarseClock::packTime(time_t time) {
+    tm localTm;
+#ifdef _WIN32
+    localtime_s(&localTm, &time);
+#else
+    localtime_r(&time, &localTm);
+#endif
+
+    char buffer[16];
+    strftime(buffer, sizeof(buffer), "%H:%M:%S", &localTm);
+
+    uint64_t packed = 0;
+    memcpy(&packed, buffer, sizeof(packed));
+    return packed;
+}
+
+void CoarseClock::start() {
+    if (m_ticker.joinable()) {
+        return;
+    }
+
+    m_packedTime = packTime(chrono::system_clock::to_time_t(chrono::system_clock::now()));
+    m_stopping = false;
+    m_ticker = thread(&CoarseClock::run, this);
+    m_running = true;
+}
+
+void CoarseClock::stop() {
+    if (!m_ticker.joinable()) {
+        return;
+    }
+
+    m_running = false;
+    {
+        lock_guard<mutex> lock(m_tickerMutex);
+        m_stopping = true;
+    }
+    m_tickerCondition.notify_all();
+    m_ticker.join();
+}
+
+// Sleeps until the next whole second, then publishes it
+void CoarseClock::run() {
+    unique_lock<mutex> lock(m_tickerMutex);
+
+    while (!m_stopping) {
+        auto nextSecond = chrono::time_point_cast<chrono::seconds>(chrono::system_clock::now()) +
+            chrono::seconds(1);
+        if (m_tickerCondition.wait_until(lock, nextSecond, [this] { return m_stopping; })) {
+            break;
+        }
+
+        m_packedTime.store(packTime(chrono::system_clock::to_time_t(chrono::system_clock::now())),
+            memory_order_relaxed);
+    }
+}
+
+string CoarseClock::getTimestamp() const {
+    uint64_t packed = m_running
+        ? m_packedTime.load(memory_order_relaxed)
+        : packTime(chrono::system_clock::to_time_t(chrono::system_clock::now()));
+
+    string timestamp(10, '[');
+    memcpy(&timestamp[1], &packed, sizeof(packed));
+    timestamp[9] = ']';
+    return timestamp;
+}
+
+int64_t getEpochMillis() {
+    return chrono::duration_cast<chrono::milliseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include "Common.h"
+
+// ============================================================================
+// COARSE CLOCK
+// ============================================================================
+// Chat lines only show the time to the second, so converting to local time
+// and running strftime for every message is wasted work. A ticker thread
+// formats "[HH:MM:SS]" once at each wall-clock second and publishes it as
+// a single atomic word; readers copy it without touching the timezone
+// code. A reader may see the previous second for the moment it takes the
+// ticker to wake.
+//
+// Until start() and after stop() the timestamp is formatted on every call.
+class CoarseClock {
+private:
+    atomic<uint64_t> m_packedTime;  // The eight characters of "HH:MM:SS"
+    atomic<bool> m_running;
+
+    thread m_ticker;
+    mutex m_tickerMutex;
+    condition_variable m_tickerCondition;
+    bool m_stopping;
+
+    static uint64_t packTime(time_t time);
+    void run();
+
+public:
+    CoarseClock();
+    ~CoarseClock();
+
+    CoarseClock(const CoarseClock&) = delete;
+    CoarseClock& operator=(const CoarseClock&) = delete;
+
+    void start();
+
+    // Safe to call more than once
+    void stop();
+
+    // "[HH:MM:SS]" in local time
+    string getTimestamp() const;
+};
+
+extern CoarseClock g_clock;
+
+// Milliseconds since the Unix epoch, straight from the system clock
+int64_t getEpochMillis();
\ No newline at end of file
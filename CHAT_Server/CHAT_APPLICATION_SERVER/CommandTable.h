@@ -0,0 +1,181 @@
+#pragma once
+#include "Common.h"
+#include <array>
+
+// ============================================================================
+// COMMAND TABLE
+// ============================================================================
+// Command frames are parsed in place: CommandTokenizer hands out
+// string_views into the frame payload, and the command name is looked up in
+// a perfect hash table built at compile time, so well-formed input is
+// dispatched without a single allocation or string comparison chain.
+
+enum class CommandId : uint8_t {
+    Create,
+    Join,
+    SetName,
+    List,
+    GetPassword,
+    Users,
+    Kick,
+    Ban,
+    Transfer,
+    Leave,
+    ForceLeave,
+    ChangePassword,
+    History,
+    Unknown         // Not a command; also the number of commands
+};
+
+constexpr size_t COMMAND_COUNT = static_cast<size_t>(CommandId::Unknown);
+
+// Wire names, indexed by CommandId
+constexpr array<string_view, COMMAND_COUNT> COMMAND_NAMES = {
+    "CREATE",
+    "JOIN",
+    "SETNAME",
+    "LIST",
+    "GETPASSWORD",
+    "USERS",
+    "KICK",
+    "BAN",
+    "TRANSFER",
+    "LEAVE",
+    "FORCELEAVE",
+    "CHANGEPASSWORD",
+    "HISTORY"
+};
+
+// Splits a command line into whitespace-separated words without copying
+class CommandTokenizer {
+private:
+    string_view m_rest;
+
+    static constexpr bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    constexpr void skipSpace() {
+        size_t i = 0;
+        while (i < m_rest.size() && isSpace(m_rest[i])) {
+            i++;
+        }
+        m_rest.remove_prefix(i);
+    }
+
+public:
+    constexpr explicit CommandTokenizer(string_view text)
+        : m_rest(text) {
+    }
+
+    // Next word, or an empty view once the line is used up
+    constexpr string_view next() {
+        skipSpace();
+        size_t length = 0;
+        while (length < m_rest.size() && !isSpace(m_rest[length])) {
+            length++;
+        }
+
+        string_view word = m_rest.substr(0, length);
+        m_rest.remove_prefix(length);
+        return word;
+    }
+
+    // Everything after the words taken so far, with surrounding whitespace
+    // removed (passwords and usernames keep their inner spaces)
+    constexpr string_view rest() {
+        skipSpace();
+        size_t length = m_rest.size();
+        while (length > 0 && isSpace(m_rest[length - 1])) {
+            length--;
+        }
+        return m_rest.substr(0, length);
+    }
+};
+
+namespace CommandTableDetail {
+
+constexpr int SLOT_BITS = 5;
+constexpr size_t SLOT_COUNT = size_t(1) << SLOT_BITS;
+static_assert(SLOT_COUNT > COMMAND_COUNT, "Command table needs more slots");
+
+// FNV-1a, perturbed by a seed so a collision-free one can be searched for
+constexpr uint32_t hashName(string_view name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// The multiply only carries upward, so the top bits are the well-mixed ones
+constexpr size_t slotOf(string_view name, uint32_t seed) {
+    return hashName(name, seed) >> (32 - SLOT_BITS);
+}
+
+constexpr bool isCollisionFree(uint32_t seed) {
+    bool used[SLOT_COUNT] = {};
+    for (string_view name : COMMAND_NAMES) {
+        size_t slot = slotOf(name, seed);
+        if (used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t findSeed() {
+    for (uint32_t seed = 0; seed < 10000; seed++) {
+        if (isCollisionFree(seed)) {
+            return seed;
+        }
+    }
+    return UINT32_MAX;
+}
+
+constexpr uint32_t SEED = findSeed();
+static_assert(SEED != UINT32_MAX, "No perfect hash seed for the command names; raise SLOT_COUNT");
+
+constexpr array<CommandId, SLOT_COUNT> buildSlots() {
+    array<CommandId, SLOT_COUNT> slots = {};
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        slots[i] = CommandId::Unknown;
+    }
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        slots[slotOf(COMMAND_NAMES[i], SEED)] = static_cast<CommandId>(i);
+    }
+    return slots;
+}
+
+constexpr array<CommandId, SLOT_COUNT> SLOTS = buildSlots();
+
+constexpr size_t longestName() {
+    size_t longest = 0;
+    for (string_view name : COMMAND_NAMES) {
+        longest = name.size() > longest ? name.size() : longest;
+    }
+    return longest;
+}
+
+constexpr size_t MAX_NAME_LENGTH = longestName();
+
+} // namespace CommandTableDetail
+
+// One hash and one comparison; CommandId::Unknown if name isn't a command
+constexpr CommandId findCommand(string_view name) {
+    using namespace CommandTableDetail;
+    if (name.empty() || name.size() > MAX_NAME_LENGTH) {
+        return CommandId::Unknown;
+    }
+
+    CommandId id = SLOTS[slotOf(name, SEED)];
+    if (id == CommandId::Unknown || COMMAND_NAMES[static_cast<size_t>(id)] != name) {
+        return CommandId::Unknown;
+    }
+    return id;
+}
+
+static_assert(findCommand("HISTORY") == CommandId::History, "Command table is inconsistent");
+static_assert(findCommand("history") == CommandId::Unknown, "Command names are case-sensitive");
\ No newline at end of file
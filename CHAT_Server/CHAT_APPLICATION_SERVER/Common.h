@@ -17,19 +17,70 @@
 #include <memory>
 #include <chrono>
 #include <ctime>
+#include <string_view>
 
+#ifdef _WIN32
 // Winsock
 #include <winsock2.h>
 #include <WS2tcpip.h>
 #include <tchar.h>
+#include <intrin.h>
 
 // Link Winsock library
 #pragma comment(lib, "ws2_32.lib")
+#else
+// POSIX sockets
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+// Map the Winsock names used by the server onto their POSIX equivalents
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define WSAEWOULDBLOCK EWOULDBLOCK
+#define closesocket close
+inline int WSAGetLastError() { return errno; }
+inline int WSACleanup() { return 0; }
+#endif
 
 // Global Definitions
 #define PORT 12345
 #define BUFFER_SIZE 4096
 #define MAX_MESSAGE_HISTORY 100
+#define DEFAULT_HISTORY_PAGE_SIZE 50
+#define MAX_HISTORY_PAGE_SIZE 500
+#define MAX_OUTBOUND_BYTES (1024 * 1024)
+#define SEND_GATHER_BUFFERS 64
+#define DEFAULT_BROADCASTER_THREADS 4
+#define DEFAULT_IO_THREADS 4
+#define DEFAULT_MAX_CONNECTIONS 50000
+#define DEFAULT_ACCEPT_BURST 256
+#define REGISTRY_SHARD_COUNT 64
+#define MESSAGE_SHARD_CAPACITY 8192 // Must be a power of two
+#define BROADCAST_BATCH_SIZE 64
+#define DEFAULT_DB_READERS 4
+#define DEFAULT_DB_BATCH_SIZE 256
+#define DEFAULT_DB_FLUSH_MS 20
+#define PERSIST_QUEUE_CAPACITY 65536
+#define DEFAULT_CLIENT_MSG_RATE 20
+#define DEFAULT_CLIENT_BYTE_RATE (32 * 1024)
+#define DEFAULT_ROOM_MSG_RATE 500
+#define DEFAULT_ROOM_BYTE_RATE (1024 * 1024)
+#define RATE_LIMIT_BURST_SECONDS 2
+#define DEFAULT_METRICS_PORT 12346
+#define METRIC_COUNTER_STRIPES 16
+#define LOG_BUFFER_CAPACITY 4096 // Lines queued per thread; a power of two
+#define LOG_FLUSH_MS 10
+#define LOG_REPEAT_LIMIT 10 // Warn/error lines per call site per second
+#define SYMBOL_CHUNK_SIZE 4096 // Names per block of the symbol table
+#define SYMBOL_MAX_CHUNKS 4096 // Up to 16M distinct usernames and room IDs
 
 // Using namespace
 using namespace std;
@@ -37,4 +88,6 @@ using namespace std;
 // Forward Declarations
 class ClientInfo;
 class Message;
-class ChatRoom;
\ No newline at end of file
+class ChatRoom;
+class EventLoop;
+class Connection;
\ No newline at end of file
@@ -0,0 +1,267 @@
+#include "Config.h"
+
+// Global configuration instance
+ServerConfig g_config;
+
+ServerConfig::ServerConfig()
+    : port(PORT)
+    , broadcasterThreads(DEFAULT_BROADCASTER_THREADS)
+    , ioThreads(DEFAULT_IO_THREADS)
+    , acceptMode(AcceptMode::RoundRobin)
+    , maxConnections(DEFAULT_MAX_CONNECTIONS)
+    , acceptRate(0)
+    , acceptBurst(DEFAULT_ACCEPT_BURST)
+    , dbReaders(DEFAULT_DB_READERS)
+    , dbBatchSize(DEFAULT_DB_BATCH_SIZE)
+    , dbFlushMs(DEFAULT_DB_FLUSH_MS)
+    , durability(Durability::Full)
+    , clientMsgRate(DEFAULT_CLIENT_MSG_RATE)
+    , clientByteRate(DEFAULT_CLIENT_BYTE_RATE)
+    , roomMsgRate(DEFAULT_ROOM_MSG_RATE)
+    , roomByteRate(DEFAULT_ROOM_BYTE_RATE)
+    , metricsPort(DEFAULT_METRICS_PORT)
+    , logLevel(LogLevel::Info)
+    , timestampMode(TimestampMode::Local) {
+}
+
+const char* acceptModeName(AcceptMode mode) {
+    switch (mode) {
+    case AcceptMode::RoundRobin:
+        return "round-robin";
+    case AcceptMode::LeastLoaded:
+        return "least-loaded";
+    case AcceptMode::ReusePort:
+        return "reuseport";
+    }
+    return "unknown";
+}
+
+const char* durabilityName(Durability durability) {
+    switch (durability) {
+    case Durability::Off:
+        return "off";
+    case Durability::Normal:
+        return "normal";
+    case Durability::Full:
+        return "full";
+    }
+    return "unknown";
+}
+
+const char* timestampModeName(TimestampMode mode) {
+    switch (mode) {
+    case TimestampMode::Local:
+        return "local";
+    case TimestampMode::EpochMillis:
+        return "epoch-ms";
+    }
+    return "unknown";
+}
+
+// Parses "--name=<integer>" into value. Returns false if arg is a
+// different option; sets valid to false if the number is malformed.
+static bool parseIntOption(const string& arg, const string& name, int& value,
+    int minValue, int maxValue, bool& valid) {
+    string prefix = "--" + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+
+    try {
+        size_t consumed = 0;
+        string text = arg.substr(prefix.size());
+        int parsed = stoi(text, &consumed);
+        if (consumed != text.size() || parsed < minValue || parsed > maxValue) {
+            valid = false;
+        }
+        else {
+            value = parsed;
+        }
+    }
+    catch (const exception&) {
+        valid = false;
+    }
+
+    if (!valid) {
+        cout << "[ERROR] Invalid value for --" << name << " (expected "
+            << minValue << "-" << maxValue << ")" << endl;
+    }
+    return true;
+}
+
+// Parses "--accept=<mode>". Returns false if arg is a different option.
+static bool parseAcceptOption(const string& arg, AcceptMode& mode, bool& valid) {
+    const string prefix = "--accept=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+
+    string text = arg.substr(prefix.size());
+    if (text == "round-robin") {
+        mode = AcceptMode::RoundRobin;
+    }
+    else if (text == "least-loaded") {
+        mode = AcceptMode::LeastLoaded;
+    }
+    else if (text == "reuseport") {
+        mode = AcceptMode::ReusePort;
+    }
+    else {
+        cout << "[ERROR] Invalid value for --accept (expected round-robin, "
+            << "least-loaded or reuseport)" << endl;
+        valid = false;
+    }
+    return true;
+}
+
+// Parses "--durability=<mode>". Returns false if arg is a different option.
+static bool parseDurabilityOption(const string& arg, Durability& durability, bool& valid) {
+    const string prefix = "--durability=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+
+    string text = arg.substr(prefix.size());
+    if (text == "off") {
+        durability = Durability::Off;
+    }
+    else if (text == "normal") {
+        durability = Durability::Normal;
+    }
+    else if (text == "full") {
+        durability = Durability::Full;
+    }
+    else {
+        cout << "[ERROR] Invalid value for --durability (expected off, "
+            << "normal or full)" << endl;
+        valid = false;
+    }
+    return true;
+}
+
+// Parses "--log-level=<level>". Returns false if arg is a different option.
+static bool parseLogLevelOption(const string& arg, LogLevel& level, bool& valid) {
+    const string prefix = "--log-level=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+
+    if (!parseLogLevel(arg.substr(prefix.size()), level)) {
+        cout << "[ERROR] Invalid value for --log-level (expected debug, "
+            << "info, warn or error)" << endl;
+        valid = false;
+    }
+    return true;
+}
+
+// Parses "--timestamps=<mode>". Returns false if arg is a different option.
+static bool parseTimestampOption(const string& arg, TimestampMode& mode, bool& valid) {
+    const string prefix = "--timestamps=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+
+    string text = arg.substr(prefix.size());
+    if (text == "local") {
+        mode = TimestampMode::Local;
+    }
+    else if (text == "epoch-ms") {
+        mode = TimestampMode::EpochMillis;
+    }
+    else {
+        cout << "[ERROR] Invalid value for --timestamps (expected local or epoch-ms)" << endl;
+        valid = false;
+    }
+    return true;
+}
+
+bool parseCommandLine(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool valid = true;
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return false;
+        }
+        else if (parseIntOption(arg, "port", g_config.port, 1, 65535, valid) ||
+            parseIntOption(arg, "broadcasters", g_config.broadcasterThreads, 1, 256, valid) ||
+            parseIntOption(arg, "io-threads", g_config.ioThreads, 1, 256, valid) ||
+            parseIntOption(arg, "max-connections", g_config.maxConnections, 1, 1000000, valid) ||
+            parseIntOption(arg, "accept-rate", g_config.acceptRate, 0, 1000000, valid) ||
+            parseIntOption(arg, "accept-burst", g_config.acceptBurst, 1, 1000000, valid) ||
+            parseIntOption(arg, "db-readers", g_config.dbReaders, 0, 64, valid) ||
+            parseIntOption(arg, "db-batch", g_config.dbBatchSize, 1, 100000, valid) ||
+            parseIntOption(arg, "db-flush-ms", g_config.dbFlushMs, 0, 10000, valid) ||
+            parseIntOption(arg, "client-rate", g_config.clientMsgRate, 0, 1000000, valid) ||
+            parseIntOption(arg, "client-bytes", g_config.clientByteRate, 0, 1000000000, valid) ||
+            parseIntOption(arg, "room-rate", g_config.roomMsgRate, 0, 1000000, valid) ||
+            parseIntOption(arg, "room-bytes", g_config.roomByteRate, 0, 1000000000, valid) ||
+            parseIntOption(arg, "metrics-port", g_config.metricsPort, 0, 65535, valid) ||
+            parseAcceptOption(arg, g_config.acceptMode, valid) ||
+            parseDurabilityOption(arg, g_config.durability, valid) ||
+            parseLogLevelOption(arg, g_config.logLevel, valid) ||
+            parseTimestampOption(arg, g_config.timestampMode, valid)) {
+            if (!valid) {
+                return false;
+            }
+        }
+        else {
+            cout << "[ERROR] Unknown option: " << arg << endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    if (g_config.acceptMode == AcceptMode::ReusePort) {
+        // Windows has no load-balancing SO_REUSEPORT equivalent
+        cout << "[WARN] --accept=reuseport is not supported on Windows, "
+            << "using round-robin" << endl;
+        g_config.acceptMode = AcceptMode::RoundRobin;
+    }
+#endif
+    return true;
+}
+
+void printUsage(const char* program) {
+    cout << "Usage: " << program << " [options]" << endl;
+    cout << "  --port=N           Listening port (default " << PORT << ")" << endl;
+    cout << "  --broadcasters=N   Broadcaster worker threads (default "
+        << DEFAULT_BROADCASTER_THREADS << ")" << endl;
+    cout << "  --io-threads=N     I/O reactor threads (default "
+        << DEFAULT_IO_THREADS << ")" << endl;
+    cout << "  --accept=MODE      Connection distribution: round-robin (default),"
+        << endl;
+    cout << "                     least-loaded or reuseport (Linux)" << endl;
+    cout << "  --max-connections=N  Refuse clients beyond N (default "
+        << DEFAULT_MAX_CONNECTIONS << ")" << endl;
+    cout << "  --accept-rate=N    Admit at most N new clients per second, 0 = no limit"
+        << " (default 0)" << endl;
+    cout << "  --accept-burst=N   Clients admitted at once before the rate applies (default "
+        << DEFAULT_ACCEPT_BURST << ")" << endl;
+    cout << "  --db-readers=N     Read-only database connections, 0 to share the writer"
+        << " (default " << DEFAULT_DB_READERS << ")" << endl;
+    cout << "  --db-batch=N       Messages per database commit (default "
+        << DEFAULT_DB_BATCH_SIZE << ")" << endl;
+    cout << "  --db-flush-ms=N    Longest a message waits to be committed (default "
+        << DEFAULT_DB_FLUSH_MS << ")" << endl;
+    cout << "  --durability=MODE  Commit sync level: off, normal or full (default)"
+        << endl;
+    cout << "  --client-rate=N    Chat/PM messages per second per client, 0 = no limit"
+        << " (default " << DEFAULT_CLIENT_MSG_RATE << ")" << endl;
+    cout << "  --client-bytes=N   Chat/PM bytes per second per client, 0 = no limit"
+        << " (default " << DEFAULT_CLIENT_BYTE_RATE << ")" << endl;
+    cout << "  --room-rate=N      Messages per second into one room, 0 = no limit"
+        << " (default " << DEFAULT_ROOM_MSG_RATE << ")" << endl;
+    cout << "  --room-bytes=N     Bytes per second into one room, 0 = no limit"
+        << " (default " << DEFAULT_ROOM_BYTE_RATE << ")" << endl;
+    cout << "  --metrics-port=N   Prometheus /metrics on 127.0.0.1:N, 0 = off (default "
+        << DEFAULT_METRICS_PORT << ")" << endl;
+    cout << "  --log-level=LEVEL  debug, info (default), warn or error; debug logs"
+        << endl;
+    cout << "                     every message" << endl;
+    cout << "  --timestamps=MODE  Chat line stamps: local [HH:MM:SS] (default) or epoch-ms"
+        << endl;
+    cout << "                     [@milliseconds] for clients to format" << endl;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+#include "Common.h"
+#include "Logger.h"
+
+// How new connections are spread over the I/O reactors
+enum class AcceptMode {
+    RoundRobin,     // Acceptor thread hands sockets out in turn
+    LeastLoaded,    // Acceptor thread picks the reactor with fewest clients
+    ReusePort       // Every reactor listens itself (SO_REUSEPORT, Linux only)
+};
+
+// How far each database commit waits for the disk (PRAGMA synchronous)
+enum class Durability {
+    Off,            // Never fsync; a power loss can lose recent batches
+    Normal,         // fsync at WAL checkpoints; survives a server crash
+    Full            // fsync every group commit
+};
+
+// How chat lines are stamped
+enum class TimestampMode {
+    Local,          // "[HH:MM:SS]" in the server's local time
+    EpochMillis     // "[@<ms since epoch>]"; clients convert to their own time
+};
+
+// Runtime settings. Defaults come from Common.h; each can be overridden
+// on the command line as --name=value (see printUsage).
+struct ServerConfig {
+    int port;
+    int broadcasterThreads;
+    int ioThreads;
+    AcceptMode acceptMode;
+    int maxConnections;
+    int acceptRate;         // New connections admitted per second, 0 = unlimited
+    int acceptBurst;
+    int dbReaders;
+    int dbBatchSize;
+    int dbFlushMs;
+    Durability durability;
+    int clientMsgRate;      // Flood limits in messages / bytes per second,
+    int clientByteRate;     // 0 = unlimited
+    int roomMsgRate;
+    int roomByteRate;
+    int metricsPort;        // Loopback admin port for /metrics, 0 = disabled
+    LogLevel logLevel;      // Starting level; the admin port can change it
+    TimestampMode timestampMode;
+
+    ServerConfig();
+};
+
+// Global configuration, filled in by parseCommandLine before startup
+extern ServerConfig g_config;
+
+// Parses command-line options into g_config. Returns false on bad input.
+bool parseCommandLine(int argc, char* argv[]);
+
+const char* acceptModeName(AcceptMode mode);
+const char* durabilityName(Durability durability);
+const char* timestampModeName(TimestampMode mode);
+
+// Prints the supported options
+void printUsage(const char* program);
\ No newline at end of file
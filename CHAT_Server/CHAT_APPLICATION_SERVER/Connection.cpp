@@ -0,0 +1,196 @@
+#include "Connection.h"
+#include "EventLoop.h"
+#include "Metrics.h"
+
+Connection::Connection(SOCKET socket, EventLoop* eventLoop)
+    : m_socket(socket)
+    , m_eventLoop(eventLoop)
+    , m_frontOffset(0)
+    , m_pendingBytes(0)
+    , m_flushScheduled(false)
+    , m_overflowed(false)
+    , m_writeInterest(false)
+    , m_closed(false) {
+}
+
+SOCKET Connection::getSocket() const {
+    return m_socket;
+}
+
+FrameDecoder& Connection::getDecoder() {
+    return m_decoder;
+}
+
+// Sends several buffers with one system call. Returns the number of bytes
+// written or SOCKET_ERROR, like send().
+static int sendBuffers(SOCKET socket, const string* const* buffers, const size_t* offsets,
+    size_t count) {
+#ifdef _WIN32
+    WSABUF wsaBuffers[SEND_GATHER_BUFFERS];
+    for (size_t i = 0; i < count; i++) {
+        wsaBuffers[i].buf = const_cast<char*>(buffers[i]->data() + offsets[i]);
+        wsaBuffers[i].len = static_cast<ULONG>(buffers[i]->size() - offsets[i]);
+    }
+
+    DWORD sent = 0;
+    if (WSASend(socket, wsaBuffers, static_cast<DWORD>(count), &sent, 0,
+        nullptr, nullptr) == SOCKET_ERROR) {
+        return SOCKET_ERROR;
+    }
+    return static_cast<int>(sent);
+#else
+    iovec vectors[SEND_GATHER_BUFFERS];
+    for (size_t i = 0; i < count; i++) {
+        vectors[i].iov_base = const_cast<char*>(buffers[i]->data() + offsets[i]);
+        vectors[i].iov_len = buffers[i]->size() - offsets[i];
+    }
+
+    msghdr message = {};
+    message.msg_iov = vectors;
+    message.msg_iovlen = count;
+    return static_cast<int>(sendmsg(socket, &message, 0));
+#endif
+}
+
+bool Connection::enqueue(const SharedPayload& payload) {
+    return enqueueFrames(&payload, 1);
+}
+
+bool Connection::enqueue(const vector<SharedPayload>& payloads) {
+    return enqueueFrames(payloads.data(), payloads.size());
+}
+
+bool Connection::enqueueFrames(const SharedPayload* payloads, size_t count) {
+    bool scheduleFlush = false;
+    bool accepted = true;
+
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        totalBytes += payloads[i]->size();
+    }
+
+    {
+        lock_guard<mutex> lock(m_outboundMutex);
+
+        // The client has gone; there is nobody left to deliver to
+        if (m_closed) {
+            return true;
+        }
+
+        if (m_overflowed) {
+            return false;
+        }
+
+        if (m_pendingBytes + totalBytes > MAX_OUTBOUND_BYTES) {
+            // Slow reader: stop queuing and let the I/O thread drop it
+            // rather than silently skipping messages
+            m_overflowed = true;
+            accepted = false;
+        }
+        else {
+            m_pendingBytes += totalBytes;
+            m_outbound.insert(m_outbound.end(), payloads, payloads + count);
+        }
+
+        if (!m_flushScheduled) {
+            m_flushScheduled = true;
+            scheduleFlush = true;
+        }
+    }
+
+    if (scheduleFlush) {
+        m_eventLoop->requestFlush(m_socket);
+    }
+    return accepted;
+}
+
+bool Connection::flush() {
+    const string* buffers[SEND_GATHER_BUFFERS];
+    size_t offsets[SEND_GATHER_BUFFERS];
+
+    while (true) {
+        size_t count = 0;
+
+        {
+            lock_guard<mutex> lock(m_outboundMutex);
+            m_flushScheduled = false;
+
+            if (m_overflowed) {
+                return false;
+            }
+
+            if (m_outbound.empty()) {
+                break;
+            }
+
+            // Producers only push_back, so these elements stay valid while
+            // the lock is released for the send call
+            for (auto it = m_outbound.begin();
+                it != m_outbound.end() && count < SEND_GATHER_BUFFERS; ++it) {
+                buffers[count] = it->get();
+                offsets[count] = (count == 0) ? m_frontOffset : 0;
+                count++;
+            }
+        }
+
+        int result = sendBuffers(m_socket, buffers, offsets, count);
+
+        if (result == SOCKET_ERROR) {
+            if (WSAGetLastError() != WSAEWOULDBLOCK) {
+                return false;
+            }
+
+            if (!m_writeInterest) {
+                m_writeInterest = true;
+                m_eventLoop->setWriteInterest(m_socket, true);
+            }
+            return true;
+        }
+
+        // Retire every frame the write covered; a partial one stays at the
+        // front with m_frontOffset marking how far it got
+        lock_guard<mutex> lock(m_outboundMutex);
+        size_t written = static_cast<size_t>(result);
+        m_pendingBytes -= written;
+        g_serverMetrics.bytesSent.add(written);
+
+        uint64_t completedFrames = 0;
+        while (written > 0) {
+            size_t remaining = m_outbound.front()->size() - m_frontOffset;
+            if (written < remaining) {
+                m_frontOffset += written;
+                break;
+            }
+
+            written -= remaining;
+            m_outbound.pop_front();
+            m_frontOffset = 0;
+            completedFrames++;
+        }
+        g_serverMetrics.framesSent.add(completedFrames);
+    }
+
+    if (m_writeInterest) {
+        m_writeInterest = false;
+        m_eventLoop->setWriteInterest(m_socket, false);
+    }
+    return true;
+}
+
+void Connection::markClosed() {
+    lock_guard<mutex> lock(m_outboundMutex);
+    m_closed = true;
+    m_outbound.clear();
+    m_frontOffset = 0;
+    m_pendingBytes = 0;
+}
+
+size_t Connection::getPendingBytes() const {
+    lock_guard<mutex> lock(m_outboundMutex);
+    return m_pendingBytes;
+}
+
+bool Connection::hasOverflowed() const {
+    lock_guard<mutex> lock(m_outboundMutex);
+    return m_overflowed;
+}
\ No newline at end of file
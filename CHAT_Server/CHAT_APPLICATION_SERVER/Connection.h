@@ -0,0 +1,60 @@
+#pragma once
+#include "Common.h"
+#include "Protocol.h"
+#include <deque>
+
+// Immutable, reference-counted encoded frame. A room message is encoded
+// once and the same buffer is shared by every recipient's outbound queue
+// and the room history, so fan-out copies a pointer, not the bytes.
+typedef shared_ptr<const string> SharedPayload;
+
+// Per-socket transport state: the inbound frame decoder and a bounded
+// outbound queue. Any thread may enqueue; only the I/O thread that owns
+// the socket reads from it or writes to it.
+class Connection {
+private:
+    SOCKET m_socket;
+    EventLoop* m_eventLoop;
+    FrameDecoder m_decoder;
+
+    deque<SharedPayload> m_outbound;
+    size_t m_frontOffset;
+    size_t m_pendingBytes;
+    bool m_flushScheduled;
+    bool m_overflowed;
+    bool m_writeInterest;
+    bool m_closed;
+    mutable mutex m_outboundMutex;
+
+    bool enqueueFrames(const SharedPayload* payloads, size_t count);
+
+public:
+    Connection(SOCKET socket, EventLoop* eventLoop);
+
+    SOCKET getSocket() const;
+    FrameDecoder& getDecoder();
+
+    // Queues encoded bytes and asks the I/O thread to flush them. Never
+    // touches the socket. Returns false if the queue limit was exceeded;
+    // the I/O thread then disconnects the client.
+    bool enqueue(const SharedPayload& payload);
+
+    // Queues several frames at once (e.g. a history replay): one lock and
+    // at most one flush request, all frames or none
+    bool enqueue(const vector<SharedPayload>& payloads);
+
+    // Writes queued bytes until the socket would block, arming write
+    // interest for the remainder. Up to SEND_GATHER_BUFFERS queued frames
+    // go out in a single scatter/gather call (WSASend / sendmsg). Returns
+    // false if the client must be disconnected (socket error or outbound
+    // overflow). I/O thread only.
+    bool flush();
+
+    // Called by the I/O thread before the socket is closed. Later enqueues
+    // from threads still holding this connection are dropped, so nothing
+    // is flushed to a descriptor the OS has handed to a new client.
+    void markClosed();
+
+    size_t getPendingBytes() const;
+    bool hasOverflowed() const;
+};
\ No newline at end of file
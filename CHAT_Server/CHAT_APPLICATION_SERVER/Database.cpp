@@ -1,14 +1,53 @@
 #include "Database.h"
+#include "Logger.h"
 #include <iomanip>
 #include <algorithm>
 
 // Global database instance
 unique_ptr<Database> g_database = nullptr;
 
-Database::Database(const string& dbPath) : m_db(nullptr) {
+// SQL for each Database::StatementId, in enum order
+static const char* const s_statementSql[] = {
+    "INSERT INTO users (username, password_hash) VALUES (?, ?);",
+    "SELECT id FROM users WHERE username = ? AND password_hash = ?;",
+    "SELECT id FROM users WHERE username = ?;",
+    "UPDATE users SET last_seen = CURRENT_TIMESTAMP WHERE username = ?;",
+    "INSERT INTO messages (room_id, sender_username, content, is_private, recipient_username) "
+        "VALUES (?, ?, ?, ?, ?);",
+    "SELECT sender_username, content, timestamp FROM messages "
+        "WHERE room_id = ? AND is_private = 0 ORDER BY id DESC LIMIT ?;",
+    "SELECT id, sender_username, content, timestamp FROM messages "
+        "WHERE room_id = ? AND is_private = 0 AND id < ? ORDER BY id DESC LIMIT ?;",
+    "SELECT sender_username, recipient_username, content, timestamp FROM messages "
+        "WHERE is_private = 1 AND ("
+        "(sender_username = ? AND recipient_username = ?) OR "
+        "(sender_username = ? AND recipient_username = ?)) "
+        "ORDER BY id DESC LIMIT ?;",
+    "INSERT INTO rooms (room_id, is_private, owner_username, password_hash) "
+        "VALUES (?, ?, ?, ?);",
+    "DELETE FROM messages WHERE room_id = ?;",
+    "DELETE FROM bans WHERE room_id = ?;",
+    "DELETE FROM rooms WHERE room_id = ?;",
+    "SELECT id FROM rooms WHERE room_id = ?;",
+    "UPDATE rooms SET owner_username = ? WHERE room_id = ?;",
+    "UPDATE rooms SET password_hash = ? WHERE room_id = ?;",
+    "INSERT OR IGNORE INTO bans (room_id, username) VALUES (?, ?);",
+    "DELETE FROM bans WHERE room_id = ? AND username = ?;",
+    "SELECT id FROM bans WHERE room_id = ? AND username = ?;",
+    "SELECT username FROM bans WHERE room_id = ?;",
+    "BEGIN IMMEDIATE;",
+    "COMMIT;",
+    "ROLLBACK;"
+};
+
+Database::Database(const string& dbPath, size_t readerCount)
+    : m_dbPath(dbPath)
+    , m_db(nullptr)
+    , m_statements()
+    , m_readerCount(readerCount) {
     int rc = sqlite3_open(dbPath.c_str(), &m_db);
     if (rc != SQLITE_OK) {
-        cerr << "[DB ERROR] Cannot open database: " << sqlite3_errmsg(m_db) << endl;
+        LOG_ERROR("[DB ERROR] Cannot open database: " << sqlite3_errmsg(m_db));
         m_db = nullptr;
     }
     else {
@@ -21,14 +60,20 @@ Database::Database(const string& dbPath) : m_db(nullptr) {
         sqlite3_exec(m_db, "PRAGMA foreign_keys=ON;", nullptr, nullptr, &errMsg);
         if (errMsg) sqlite3_free(errMsg);
 
-        cout << "[DB] Database opened successfully: " << dbPath << endl;
+        // Wait out a checkpoint instead of failing with SQLITE_BUSY
+        sqlite3_busy_timeout(m_db, 5000);
+
+        LOG_INFO("[DB] Database opened successfully: " << dbPath);
     }
 }
 
 Database::~Database() {
+    closeReaders();
+    finalizeStatements(m_statements);
+
     if (m_db) {
         sqlite3_close(m_db);
-        cout << "[DB] Database closed" << endl;
+        LOG_INFO("[DB] Database closed");
     }
 }
 
@@ -41,16 +86,145 @@ bool Database::executeQuery(const string& query) {
     int rc = sqlite3_exec(m_db, query.c_str(), nullptr, nullptr, &errMsg);
 
     if (rc != SQLITE_OK) {
-        cerr << "[DB ERROR] Query failed: " << errMsg << endl;
+        LOG_ERROR("[DB ERROR] Query failed: " << errMsg);
         sqlite3_free(errMsg);
         return false;
     }
     return true;
 }
 
+bool Database::prepareStatements(sqlite3* db, sqlite3_stmt** statements) {
+    static_assert(sizeof(s_statementSql) / sizeof(s_statementSql[0]) == STMT_COUNT,
+        "s_statementSql must have one entry per StatementId");
+
+    for (int i = 0; i < STMT_COUNT; i++) {
+        // PERSISTENT tells SQLite the statement is long-lived so it can
+        // allocate it outside the short-lived lookaside pool
+        if (sqlite3_prepare_v3(db, s_statementSql[i], -1, SQLITE_PREPARE_PERSISTENT,
+            &statements[i], nullptr) != SQLITE_OK) {
+            LOG_ERROR("[DB ERROR] Prepare statement " << i << ": "
+                << sqlite3_errmsg(db));
+            finalizeStatements(statements);
+            return false;
+        }
+    }
+    return true;
+}
+
+void Database::finalizeStatements(sqlite3_stmt** statements) {
+    for (int i = 0; i < STMT_COUNT; i++) {
+        if (statements[i]) {
+            sqlite3_finalize(statements[i]);
+            statements[i] = nullptr;
+        }
+    }
+}
+
+bool Database::openReaders() {
+    // Each in-memory connection is a separate database; keep every read
+    // on the writer there
+    if (m_dbPath == ":memory:" || m_dbPath.empty()) {
+        m_readerCount = 0;
+    }
+
+    for (size_t i = 0; i < m_readerCount; i++) {
+        unique_ptr<ReaderConnection> reader = make_unique<ReaderConnection>();
+        reader->db = nullptr;
+        fill(begin(reader->statements), end(reader->statements), nullptr);
+
+        // NOMUTEX: the pool already guarantees one user per connection
+        int rc = sqlite3_open_v2(m_dbPath.c_str(), &reader->db,
+            SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr);
+        if (rc != SQLITE_OK) {
+            LOG_ERROR("[DB ERROR] Cannot open reader: " << sqlite3_errmsg(reader->db));
+            sqlite3_close(reader->db);
+            return false;
+        }
+        sqlite3_busy_timeout(reader->db, 5000);
+
+        if (!prepareStatements(reader->db, reader->statements)) {
+            sqlite3_close(reader->db);
+            return false;
+        }
+
+        m_idleReaders.push_back(reader.get());
+        m_readers.push_back(move(reader));
+    }
+    return true;
+}
+
+void Database::closeReaders() {
+    lock_guard<mutex> lock(m_readerMutex);
+    for (auto& reader : m_readers) {
+        finalizeStatements(reader->statements);
+        sqlite3_close(reader->db);
+    }
+    m_idleReaders.clear();
+    m_readers.clear();
+}
+
+Database::ReadLease::ReadLease(Database& database)
+    : m_database(database)
+    , m_reader(nullptr) {
+    if (m_database.m_readers.empty()) {
+        m_writerLock = unique_lock<mutex>(m_database.m_dbMutex);
+        return;
+    }
+
+    unique_lock<mutex> lock(m_database.m_readerMutex);
+    m_database.m_readerCV.wait(lock, [this] {
+        return !m_database.m_idleReaders.empty();
+        });
+    m_reader = m_database.m_idleReaders.back();
+    m_database.m_idleReaders.pop_back();
+}
+
+Database::ReadLease::~ReadLease() {
+    if (!m_reader) {
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(m_database.m_readerMutex);
+        m_database.m_idleReaders.push_back(m_reader);
+    }
+    m_database.m_readerCV.notify_one();
+}
+
+sqlite3_stmt* Database::ReadLease::getStatement(StatementId id) const {
+    return m_reader ? m_reader->statements[id] : m_database.getStatement(id);
+}
+
+sqlite3_stmt* Database::getStatement(StatementId id) {
+    return m_db ? m_statements[id] : nullptr;
+}
+
+void Database::resetStatement(sqlite3_stmt* stmt) {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+}
+
+bool Database::stepSimple(StatementId id) {
+    sqlite3_stmt* stmt = getStatement(id);
+    if (!stmt) {
+        return false;
+    }
+
+    int rc = sqlite3_step(stmt);
+    resetStatement(stmt);
+    return (rc == SQLITE_DONE);
+}
+
+bool Database::setSynchronous(const string& level) {
+    if (!m_db) return false;
+
+    lock_guard<mutex> lock(m_dbMutex);
+    return executeQuery("PRAGMA synchronous=" + level + ";");
+}
+
 bool Database::initialize() {
     if (!m_db) {
-        cerr << "[DB ERROR] Database not connected" << endl;
+        LOG_ERROR("[DB ERROR] Database not connected");
         return false;
     }
 
@@ -105,8 +279,6 @@ bool Database::initialize() {
 
     // Create indexes for performance
     const char* createIndexes = R"(
-        CREATE INDEX IF NOT EXISTS idx_messages_room ON messages(room_id);
-        CREATE INDEX IF NOT EXISTS idx_messages_timestamp ON messages(timestamp);
         CREATE INDEX IF NOT EXISTS idx_messages_sender ON messages(sender_username);
         CREATE INDEX IF NOT EXISTS idx_bans_room ON bans(room_id);
         CREATE INDEX IF NOT EXISTS idx_users_username ON users(username);
@@ -115,36 +287,90 @@ bool Database::initialize() {
     char* errMsg = nullptr;
 
     if (sqlite3_exec(m_db, createUsersTable, nullptr, nullptr, &errMsg) != SQLITE_OK) {
-        cerr << "[DB ERROR] Users table: " << errMsg << endl;
+        LOG_ERROR("[DB ERROR] Users table: " << errMsg);
         sqlite3_free(errMsg);
         return false;
     }
 
     if (sqlite3_exec(m_db, createRoomsTable, nullptr, nullptr, &errMsg) != SQLITE_OK) {
-        cerr << "[DB ERROR] Rooms table: " << errMsg << endl;
+        LOG_ERROR("[DB ERROR] Rooms table: " << errMsg);
         sqlite3_free(errMsg);
         return false;
     }
 
     if (sqlite3_exec(m_db, createMessagesTable, nullptr, nullptr, &errMsg) != SQLITE_OK) {
-        cerr << "[DB ERROR] Messages table: " << errMsg << endl;
+        LOG_ERROR("[DB ERROR] Messages table: " << errMsg);
         sqlite3_free(errMsg);
         return false;
     }
 
     if (sqlite3_exec(m_db, createBansTable, nullptr, nullptr, &errMsg) != SQLITE_OK) {
-        cerr << "[DB ERROR] Bans table: " << errMsg << endl;
+        LOG_ERROR("[DB ERROR] Bans table: " << errMsg);
         sqlite3_free(errMsg);
         return false;
     }
 
     if (sqlite3_exec(m_db, createIndexes, nullptr, nullptr, &errMsg) != SQLITE_OK) {
-        cerr << "[DB ERROR] Indexes: " << errMsg << endl;
+        LOG_ERROR("[DB ERROR] Indexes: " << errMsg);
         sqlite3_free(errMsg);
         return false;
     }
 
-    cout << "[DB] Database schema initialized successfully" << endl;
+    if (!migrateSchema()) {
+        return false;
+    }
+
+    if (!prepareStatements(m_db, m_statements)) {
+        return false;
+    }
+
+    // Readers open after the schema exists, or their statements won't prepare
+    if (!openReaders()) {
+        return false;
+    }
+
+    LOG_INFO("[DB] Database schema initialized successfully ("
+        << m_readers.size() << " reader connections)");
+    return true;
+}
+
+// Schema changes applied on top of the CREATE TABLE statements, tracked in
+// PRAGMA user_version. Each step runs once, in its own transaction.
+bool Database::migrateSchema() {
+    static const char* const migrations[] = {
+        // 1: History is read by (room, visibility) newest-first by id. The
+        // composite index serves that filter and order directly and
+        // replaces the single-column room and timestamp indexes, which
+        // forced a sort on every history query.
+        R"(
+            CREATE INDEX IF NOT EXISTS idx_messages_room_history
+                ON messages(room_id, is_private, id);
+            DROP INDEX IF EXISTS idx_messages_room;
+            DROP INDEX IF EXISTS idx_messages_timestamp;
+        )"
+    };
+    const int latestVersion = static_cast<int>(sizeof(migrations) / sizeof(migrations[0]));
+
+    sqlite3_stmt* stmt = nullptr;
+    int version = 0;
+    if (sqlite3_prepare_v2(m_db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            version = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    for (int next = version + 1; next <= latestVersion; next++) {
+        string script = string("BEGIN IMMEDIATE;") + migrations[next - 1] +
+            "PRAGMA user_version = " + to_string(next) + ";COMMIT;";
+
+        if (!executeQuery(script)) {
+            executeQuery("ROLLBACK;");
+            LOG_ERROR("[DB ERROR] Schema migration " << next << " failed");
+            return false;
+        }
+        LOG_INFO("[DB] Applied schema migration " << next);
+    }
     return true;
 }
 
@@ -157,11 +383,8 @@ bool Database::createUser(const string& username, const string& passwordHash) {
 
     lock_guard<mutex> lock(m_dbMutex);
 
-    sqlite3_stmt* stmt;
-    const char* sql = "INSERT INTO users (username, password_hash) VALUES (?, ?);";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        cerr << "[DB ERROR] Prepare createUser: " << sqlite3_errmsg(m_db) << endl;
+    sqlite3_stmt* stmt = getStatement(STMT_CREATE_USER);
+    if (!stmt) {
         return false;
     }
 
@@ -169,26 +392,23 @@ bool Database::createUser(const string& username, const string& passwordHash) {
     sqlite3_bind_text(stmt, 2, passwordHash.c_str(), -1, SQLITE_TRANSIENT);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     if (rc != SQLITE_DONE) {
-        cerr << "[DB ERROR] Execute createUser: " << sqlite3_errmsg(m_db) << endl;
+        LOG_ERROR("[DB ERROR] Execute createUser: " << sqlite3_errmsg(m_db));
         return false;
     }
 
-    cout << "[DB] User created: " << username << endl;
+    LOG_INFO("[DB] User created: " << username);
     return true;
 }
 
 bool Database::authenticateUser(const string& username, const string& passwordHash) {
     if (!m_db) return false;
 
-    lock_guard<mutex> lock(m_dbMutex);
-
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id FROM users WHERE username = ? AND password_hash = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    ReadLease reader(*this);
+    sqlite3_stmt* stmt = reader.getStatement(STMT_AUTHENTICATE_USER);
+    if (!stmt) {
         return false;
     }
 
@@ -196,7 +416,7 @@ bool Database::authenticateUser(const string& username, const string& passwordHa
     sqlite3_bind_text(stmt, 2, passwordHash.c_str(), -1, SQLITE_TRANSIENT);
 
     bool authenticated = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     return authenticated;
 }
@@ -204,19 +424,16 @@ bool Database::authenticateUser(const string& username, const string& passwordHa
 bool Database::userExists(const string& username) {
     if (!m_db) return false;
 
-    lock_guard<mutex> lock(m_dbMutex);
-
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id FROM users WHERE username = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    ReadLease reader(*this);
+    sqlite3_stmt* stmt = reader.getStatement(STMT_USER_EXISTS);
+    if (!stmt) {
         return false;
     }
 
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
 
     bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     return exists;
 }
@@ -226,17 +443,15 @@ bool Database::updateLastSeen(const string& username) {
 
     lock_guard<mutex> lock(m_dbMutex);
 
-    sqlite3_stmt* stmt;
-    const char* sql = "UPDATE users SET last_seen = CURRENT_TIMESTAMP WHERE username = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    sqlite3_stmt* stmt = getStatement(STMT_UPDATE_LAST_SEEN);
+    if (!stmt) {
         return false;
     }
 
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     return (rc == SQLITE_DONE);
 }
@@ -251,54 +466,69 @@ void Database::saveMessage(const string& roomId, const string& sender,
     if (!m_db) return;
 
     lock_guard<mutex> lock(m_dbMutex);
+    insertMessage({ roomId, sender, content, isPrivate, recipient });
+}
 
-    sqlite3_stmt* stmt;
-    const char* sql = R"(
-        INSERT INTO messages (room_id, sender_username, content, is_private, recipient_username) 
-        VALUES (?, ?, ?, ?, ?);
-    )";
+bool Database::saveMessages(const vector<MessageRecord>& messages) {
+    if (!m_db) return false;
+    if (messages.empty()) return true;
 
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        cerr << "[DB ERROR] Prepare saveMessage: " << sqlite3_errmsg(m_db) << endl;
-        return;
+    lock_guard<mutex> lock(m_dbMutex);
+
+    if (!stepSimple(STMT_BEGIN)) {
+        LOG_ERROR("[DB ERROR] Begin saveMessages: " << sqlite3_errmsg(m_db));
+        return false;
     }
 
-    sqlite3_bind_text(stmt, 1, roomId.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, sender.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, content.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 4, isPrivate ? 1 : 0);
+    for (const MessageRecord& message : messages) {
+        if (!insertMessage(message)) {
+            stepSimple(STMT_ROLLBACK);
+            return false;
+        }
+    }
+
+    if (!stepSimple(STMT_COMMIT)) {
+        LOG_ERROR("[DB ERROR] Commit saveMessages: " << sqlite3_errmsg(m_db));
+        stepSimple(STMT_ROLLBACK);
+        return false;
+    }
+    return true;
+}
 
-    if (recipient.empty()) {
+bool Database::insertMessage(const MessageRecord& message) {
+    sqlite3_stmt* stmt = getStatement(STMT_SAVE_MESSAGE);
+    if (!stmt) {
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, message.roomId.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, message.sender.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, message.content.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 4, message.isPrivate ? 1 : 0);
+
+    if (message.recipient.empty()) {
         sqlite3_bind_null(stmt, 5);
     }
     else {
-        sqlite3_bind_text(stmt, 5, recipient.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 5, message.recipient.c_str(), -1, SQLITE_TRANSIENT);
     }
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        cerr << "[DB ERROR] Execute saveMessage: " << sqlite3_errmsg(m_db) << endl;
+    bool inserted = (sqlite3_step(stmt) == SQLITE_DONE);
+    if (!inserted) {
+        LOG_ERROR("[DB ERROR] Execute saveMessage: " << sqlite3_errmsg(m_db));
     }
 
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
+    return inserted;
 }
 
 vector<string> Database::getMessageHistory(const string& roomId, int limit) {
     vector<string> history;
     if (!m_db) return history;
 
-    lock_guard<mutex> lock(m_dbMutex);
-
-    sqlite3_stmt* stmt;
-    const char* sql = R"(
-        SELECT sender_username, content, timestamp 
-        FROM messages 
-        WHERE room_id = ? AND is_private = 0
-        ORDER BY timestamp DESC 
-        LIMIT ?;
-    )";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        cerr << "[DB ERROR] Prepare getMessageHistory: " << sqlite3_errmsg(m_db) << endl;
+    ReadLease reader(*this);
+    sqlite3_stmt* stmt = reader.getStatement(STMT_GET_MESSAGE_HISTORY);
+    if (!stmt) {
         return history;
     }
 
@@ -319,32 +549,61 @@ vector<string> Database::getMessageHistory(const string& roomId, int limit) {
         history.push_back(ss.str());
     }
 
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     // Reverse to chronological order
     reverse(history.begin(), history.end());
     return history;
 }
 
+HistoryPage Database::getMessageHistoryPage(const string& roomId, int64_t beforeId,
+    int pageSize) {
+    HistoryPage page = {};
+    if (!m_db) return page;
+
+    ReadLease reader(*this);
+    sqlite3_stmt* stmt = reader.getStatement(STMT_GET_MESSAGE_HISTORY_PAGE);
+    if (!stmt) {
+        return page;
+    }
+
+    // One extra row tells us whether an older page exists
+    sqlite3_bind_text(stmt, 1, roomId.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, beforeId > 0 ? beforeId : INT64_MAX);
+    sqlite3_bind_int(stmt, 3, pageSize + 1);
+
+    int64_t oldestId = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (static_cast<int>(page.lines.size()) == pageSize) {
+            page.nextBeforeId = oldestId;
+            break;
+        }
+
+        const char* senderPtr = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        const char* contentPtr = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        const char* timestampPtr = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+
+        string sender = senderPtr ? senderPtr : "";
+        string content = contentPtr ? contentPtr : "";
+        string timestamp = timestampPtr ? timestampPtr : "";
+
+        oldestId = sqlite3_column_int64(stmt, 0);
+        page.lines.push_back("[" + timestamp + "] " + sender + ": " + content + "\n");
+    }
+
+    resetStatement(stmt);
+
+    reverse(page.lines.begin(), page.lines.end());
+    return page;
+}
+
 vector<string> Database::getPrivateMessages(const string& user1, const string& user2, int limit) {
     vector<string> history;
     if (!m_db) return history;
 
-    lock_guard<mutex> lock(m_dbMutex);
-
-    sqlite3_stmt* stmt;
-    const char* sql = R"(
-        SELECT sender_username, recipient_username, content, timestamp 
-        FROM messages 
-        WHERE is_private = 1 AND (
-            (sender_username = ? AND recipient_username = ?) OR
-            (sender_username = ? AND recipient_username = ?)
-        )
-        ORDER BY timestamp DESC 
-        LIMIT ?;
-    )";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    ReadLease reader(*this);
+    sqlite3_stmt* stmt = reader.getStatement(STMT_GET_PRIVATE_MESSAGES);
+    if (!stmt) {
         return history;
     }
 
@@ -368,7 +627,7 @@ vector<string> Database::getPrivateMessages(const string& user1, const string& u
         history.push_back(ss.str());
     }
 
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     reverse(history.begin(), history.end());
     return history;
@@ -384,13 +643,8 @@ bool Database::createRoom(const string& roomId, bool isPrivate,
 
     lock_guard<mutex> lock(m_dbMutex);
 
-    sqlite3_stmt* stmt;
-    const char* sql = R"(
-        INSERT INTO rooms (room_id, is_private, owner_username, password_hash) 
-        VALUES (?, ?, ?, ?);
-    )";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    sqlite3_stmt* stmt = getStatement(STMT_CREATE_ROOM);
+    if (!stmt) {
         return false;
     }
 
@@ -406,10 +660,10 @@ bool Database::createRoom(const string& roomId, bool isPrivate,
     }
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     if (rc == SQLITE_DONE) {
-        cout << "[DB] Room created: " << roomId << endl;
+        LOG_INFO("[DB] Room created: " << roomId);
         return true;
     }
     return false;
@@ -421,37 +675,34 @@ bool Database::deleteRoom(const string& roomId) {
     lock_guard<mutex> lock(m_dbMutex);
 
     // Delete room messages
-    sqlite3_stmt* stmt;
-    const char* sqlMessages = "DELETE FROM messages WHERE room_id = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sqlMessages, -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_stmt* stmt = getStatement(STMT_DELETE_ROOM_MESSAGES);
+    if (stmt) {
         sqlite3_bind_text(stmt, 1, roomId.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        resetStatement(stmt);
     }
 
     // Delete room bans
-    const char* sqlBans = "DELETE FROM bans WHERE room_id = ?;";
-    if (sqlite3_prepare_v2(m_db, sqlBans, -1, &stmt, nullptr) == SQLITE_OK) {
+    stmt = getStatement(STMT_DELETE_ROOM_BANS);
+    if (stmt) {
         sqlite3_bind_text(stmt, 1, roomId.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        resetStatement(stmt);
     }
 
     // Delete room
-    const char* sqlRoom = "DELETE FROM rooms WHERE room_id = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sqlRoom, -1, &stmt, nullptr) != SQLITE_OK) {
+    stmt = getStatement(STMT_DELETE_ROOM);
+    if (!stmt) {
         return false;
     }
 
     sqlite3_bind_text(stmt, 1, roomId.c_str(), -1, SQLITE_TRANSIENT);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     if (rc == SQLITE_DONE) {
-        cout << "[DB] Room deleted: " << roomId << endl;
+        LOG_INFO("[DB] Room deleted: " << roomId);
         return true;
     }
     return false;
@@ -460,19 +711,16 @@ bool Database::deleteRoom(const string& roomId) {
 bool Database::roomExists(const string& roomId) {
     if (!m_db) return false;
 
-    lock_guard<mutex> lock(m_dbMutex);
-
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id FROM rooms WHERE room_id = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    ReadLease reader(*this);
+    sqlite3_stmt* stmt = reader.getStatement(STMT_ROOM_EXISTS);
+    if (!stmt) {
         return false;
     }
 
     sqlite3_bind_text(stmt, 1, roomId.c_str(), -1, SQLITE_TRANSIENT);
 
     bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     return exists;
 }
@@ -482,10 +730,8 @@ bool Database::updateRoomOwner(const string& roomId, const string& newOwner) {
 
     lock_guard<mutex> lock(m_dbMutex);
 
-    sqlite3_stmt* stmt;
-    const char* sql = "UPDATE rooms SET owner_username = ? WHERE room_id = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    sqlite3_stmt* stmt = getStatement(STMT_UPDATE_ROOM_OWNER);
+    if (!stmt) {
         return false;
     }
 
@@ -493,7 +739,7 @@ bool Database::updateRoomOwner(const string& roomId, const string& newOwner) {
     sqlite3_bind_text(stmt, 2, roomId.c_str(), -1, SQLITE_TRANSIENT);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     return (rc == SQLITE_DONE);
 }
@@ -503,10 +749,8 @@ bool Database::updateRoomPassword(const string& roomId, const string& newPasswor
 
     lock_guard<mutex> lock(m_dbMutex);
 
-    sqlite3_stmt* stmt;
-    const char* sql = "UPDATE rooms SET password_hash = ? WHERE room_id = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    sqlite3_stmt* stmt = getStatement(STMT_UPDATE_ROOM_PASSWORD);
+    if (!stmt) {
         return false;
     }
 
@@ -514,7 +758,7 @@ bool Database::updateRoomPassword(const string& roomId, const string& newPasswor
     sqlite3_bind_text(stmt, 2, roomId.c_str(), -1, SQLITE_TRANSIENT);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     return (rc == SQLITE_DONE);
 }
@@ -528,10 +772,8 @@ bool Database::addBan(const string& roomId, const string& username) {
 
     lock_guard<mutex> lock(m_dbMutex);
 
-    sqlite3_stmt* stmt;
-    const char* sql = "INSERT OR IGNORE INTO bans (room_id, username) VALUES (?, ?);";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    sqlite3_stmt* stmt = getStatement(STMT_ADD_BAN);
+    if (!stmt) {
         return false;
     }
 
@@ -539,7 +781,7 @@ bool Database::addBan(const string& roomId, const string& username) {
     sqlite3_bind_text(stmt, 2, username.c_str(), -1, SQLITE_TRANSIENT);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     return (rc == SQLITE_DONE);
 }
@@ -549,10 +791,8 @@ bool Database::removeBan(const string& roomId, const string& username) {
 
     lock_guard<mutex> lock(m_dbMutex);
 
-    sqlite3_stmt* stmt;
-    const char* sql = "DELETE FROM bans WHERE room_id = ? AND username = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    sqlite3_stmt* stmt = getStatement(STMT_REMOVE_BAN);
+    if (!stmt) {
         return false;
     }
 
@@ -560,7 +800,7 @@ bool Database::removeBan(const string& roomId, const string& username) {
     sqlite3_bind_text(stmt, 2, username.c_str(), -1, SQLITE_TRANSIENT);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     return (rc == SQLITE_DONE);
 }
@@ -568,12 +808,9 @@ bool Database::removeBan(const string& roomId, const string& username) {
 bool Database::isUserBanned(const string& roomId, const string& username) {
     if (!m_db) return false;
 
-    lock_guard<mutex> lock(m_dbMutex);
-
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id FROM bans WHERE room_id = ? AND username = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    ReadLease reader(*this);
+    sqlite3_stmt* stmt = reader.getStatement(STMT_IS_USER_BANNED);
+    if (!stmt) {
         return false;
     }
 
@@ -581,7 +818,7 @@ bool Database::isUserBanned(const string& roomId, const string& username) {
     sqlite3_bind_text(stmt, 2, username.c_str(), -1, SQLITE_TRANSIENT);
 
     bool banned = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
 
     return banned;
 }
@@ -590,12 +827,9 @@ vector<string> Database::getBannedUsers(const string& roomId) {
     vector<string> bannedUsers;
     if (!m_db) return bannedUsers;
 
-    lock_guard<mutex> lock(m_dbMutex);
-
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT username FROM bans WHERE room_id = ?;";
-
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    ReadLease reader(*this);
+    sqlite3_stmt* stmt = reader.getStatement(STMT_GET_BANNED_USERS);
+    if (!stmt) {
         return bannedUsers;
     }
 
@@ -608,6 +842,6 @@ vector<string> Database::getBannedUsers(const string& roomId) {
         }
     }
 
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
     return bannedUsers;
 }
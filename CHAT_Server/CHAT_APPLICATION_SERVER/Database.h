@@ -1,21 +1,124 @@
 #pragma once
 #include "Common.h"
 #include <sqlite3.h>
+#include <cstdint>
+
+// One chat message row, as written by saveMessages
+struct MessageRecord {
+    string roomId;
+    string sender;
+    string content;
+    bool isPrivate;
+    string recipient;
+};
+
+// One page of room history, oldest line first
+struct HistoryPage {
+    vector<string> lines;
+    int64_t nextBeforeId;   // Cursor for the next (older) page; 0 if there is none
+};
 
 class Database {
 private:
+    // Statements prepared once in initialize() and reused for the lifetime
+    // of the connection. The order matches s_statementSql in Database.cpp.
+    enum StatementId {
+        STMT_CREATE_USER,
+        STMT_AUTHENTICATE_USER,
+        STMT_USER_EXISTS,
+        STMT_UPDATE_LAST_SEEN,
+        STMT_SAVE_MESSAGE,
+        STMT_GET_MESSAGE_HISTORY,
+        STMT_GET_MESSAGE_HISTORY_PAGE,
+        STMT_GET_PRIVATE_MESSAGES,
+        STMT_CREATE_ROOM,
+        STMT_DELETE_ROOM_MESSAGES,
+        STMT_DELETE_ROOM_BANS,
+        STMT_DELETE_ROOM,
+        STMT_ROOM_EXISTS,
+        STMT_UPDATE_ROOM_OWNER,
+        STMT_UPDATE_ROOM_PASSWORD,
+        STMT_ADD_BAN,
+        STMT_REMOVE_BAN,
+        STMT_IS_USER_BANNED,
+        STMT_GET_BANNED_USERS,
+        STMT_BEGIN,
+        STMT_COMMIT,
+        STMT_ROLLBACK,
+        STMT_COUNT
+    };
+
+    // Read-only connection with its own statement cache, used by one
+    // thread at a time
+    struct ReaderConnection {
+        sqlite3* db;
+        sqlite3_stmt* statements[STMT_COUNT];
+    };
+
+    // Borrows an idle reader for the lifetime of the lease, waiting if all
+    // are busy. Without a reader pool (e.g. an in-memory database, which
+    // other connections can't see) it borrows the writer under m_dbMutex.
+    class ReadLease {
+    private:
+        Database& m_database;
+        ReaderConnection* m_reader;
+        unique_lock<mutex> m_writerLock;
+
+    public:
+        explicit ReadLease(Database& database);
+        ~ReadLease();
+
+        ReadLease(const ReadLease&) = delete;
+        ReadLease& operator=(const ReadLease&) = delete;
+
+        sqlite3_stmt* getStatement(StatementId id) const;
+    };
+
+    // Writer connection: every INSERT/UPDATE/DELETE goes through it,
+    // serialized by m_dbMutex
+    string m_dbPath;
     sqlite3* m_db;
+    sqlite3_stmt* m_statements[STMT_COUNT];
     mutex m_dbMutex;
 
+    // Reader pool. WAL lets these run alongside the writer, so history and
+    // ban lookups don't wait for a commit in progress.
+    size_t m_readerCount;
+    vector<unique_ptr<ReaderConnection>> m_readers;
+    vector<ReaderConnection*> m_idleReaders;
+    mutex m_readerMutex;
+    condition_variable m_readerCV;
+
     bool executeQuery(const string& query);
+    bool migrateSchema();
+    static bool prepareStatements(sqlite3* db, sqlite3_stmt** statements);
+    static void finalizeStatements(sqlite3_stmt** statements);
+    bool openReaders();
+    void closeReaders();
+
+    // Returns a cached writer statement ready for binding, or nullptr if
+    // the database is unavailable. Call resetStatement() when done with it.
+    sqlite3_stmt* getStatement(StatementId id);
+    static void resetStatement(sqlite3_stmt* stmt);
+
+    // Runs a cached statement that takes no parameters (m_dbMutex held)
+    bool stepSimple(StatementId id);
+
+    // Inserts one message row (m_dbMutex held)
+    bool insertMessage(const MessageRecord& message);
 
 public:
-    Database(const string& dbPath = "chatserver.db");
+    // readerCount read-only connections are opened by initialize(); with
+    // zero, reads share the writer connection
+    Database(const string& dbPath = "chatserver.db", size_t readerCount = DEFAULT_DB_READERS);
     ~Database();
 
     bool initialize();
     bool isConnected() const;
 
+    // Sets PRAGMA synchronous: "OFF", "NORMAL" or "FULL"
+    bool setSynchronous(const string& level);
+
     // User operations
     bool createUser(const string& username, const string& passwordHash);
     bool authenticateUser(const string& username, const string& passwordHash);
@@ -26,7 +129,13 @@ public:
     void saveMessage(const string& roomId, const string& sender,
                      const string& content, bool isPrivate = false,
                      const string& recipient = "");
+    // Inserts all rows in a single transaction (one commit, one fsync)
+    bool saveMessages(const vector<MessageRecord>& messages);
     vector<string> getMessageHistory(const string& roomId, int limit = MAX_MESSAGE_HISTORY);
+    // Keyset pagination: up to pageSize public messages with id < beforeId
+    // (beforeId 0 = newest). Seeks straight to the cursor through the
+    // (room_id, is_private, id) index, however far back it is.
+    HistoryPage getMessageHistoryPage(const string& roomId, int64_t beforeId, int pageSize);
     vector<string> getPrivateMessages(const string& user1, const string& user2, int limit = 50);
 
     // Room operations
@@ -0,0 +1,288 @@
+#include "EventLoop.h"
+#include "Logger.h"
+#include <unordered_map>
+
+// ============================================================================
+// FLUSH REQUESTS (all backends)
+// ============================================================================
+
+void EventLoop::requestFlush(SOCKET socket) {
+    bool wasEmpty;
+    {
+        lock_guard<mutex> lock(m_flushMutex);
+        wasEmpty = m_flushRequests.empty();
+        m_flushRequests.push_back(socket);
+    }
+
+    // Requests already pending are taken by the wakeup that is already on
+    // its way, so only the first one since the last take signals the loop
+    if (wasEmpty) {
+        wakeup();
+    }
+}
+
+void EventLoop::takeFlushRequests(vector<SOCKET>& sockets) {
+    sockets.clear();
+    lock_guard<mutex> lock(m_flushMutex);
+    sockets.swap(m_flushRequests);
+}
+
+#ifdef _WIN32
+
+// ============================================================================
+// WSAPOLL BACKEND (Windows)
+// ============================================================================
+
+class WSAPollEventLoop : public EventLoop {
+private:
+    vector<WSAPOLLFD> m_pollFds;
+    unordered_map<SOCKET, size_t> m_indices;
+
+    // Loopback UDP socket polled alongside the clients; wakeup() sends a
+    // datagram to it because WSAPoll has no native cross-thread signal
+    SOCKET m_wakeupSocket;
+    sockaddr_in m_wakeupAddr;
+
+public:
+    WSAPollEventLoop()
+        : m_wakeupSocket(INVALID_SOCKET)
+        , m_wakeupAddr() {
+        m_wakeupSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (m_wakeupSocket == INVALID_SOCKET) {
+            LOG_ERROR("[ERROR] Wakeup socket creation failed: " << WSAGetLastError());
+            return;
+        }
+
+        m_wakeupAddr.sin_family = AF_INET;
+        m_wakeupAddr.sin_port = 0;
+        inet_pton(AF_INET, "127.0.0.1", &m_wakeupAddr.sin_addr);
+
+        int addrLen = sizeof(m_wakeupAddr);
+        bind(m_wakeupSocket, (sockaddr*)&m_wakeupAddr, addrLen);
+        getsockname(m_wakeupSocket, (sockaddr*)&m_wakeupAddr, &addrLen);
+
+        u_long mode = 1;
+        ioctlsocket(m_wakeupSocket, FIONBIO, &mode);
+        addSocket(m_wakeupSocket);
+    }
+
+    ~WSAPollEventLoop() override {
+        if (m_wakeupSocket != INVALID_SOCKET) {
+            closesocket(m_wakeupSocket);
+        }
+    }
+
+    bool addSocket(SOCKET socket) override {
+        if (m_indices.count(socket)) {
+            return true;
+        }
+
+        WSAPOLLFD pollFd = {};
+        pollFd.fd = socket;
+        pollFd.events = POLLRDNORM;
+
+        m_indices[socket] = m_pollFds.size();
+        m_pollFds.push_back(pollFd);
+        return true;
+    }
+
+    void removeSocket(SOCKET socket) override {
+        auto it = m_indices.find(socket);
+        if (it == m_indices.end()) {
+            return;
+        }
+
+        // Swap with the last entry so removal stays O(1)
+        size_t index = it->second;
+        size_t lastIndex = m_pollFds.size() - 1;
+        if (index != lastIndex) {
+            m_pollFds[index] = m_pollFds[lastIndex];
+            m_indices[m_pollFds[index].fd] = index;
+        }
+
+        m_pollFds.pop_back();
+        m_indices.erase(it);
+    }
+
+    void setWriteInterest(SOCKET socket, bool enabled) override {
+        auto it = m_indices.find(socket);
+        if (it == m_indices.end()) {
+            return;
+        }
+
+        WSAPOLLFD& pollFd = m_pollFds[it->second];
+        pollFd.events = enabled ? (POLLRDNORM | POLLWRNORM) : POLLRDNORM;
+    }
+
+    int wait(vector<IoEvent>& events, int timeoutMs) override {
+        events.clear();
+
+        int pollResult = WSAPoll(m_pollFds.data(),
+            static_cast<ULONG>(m_pollFds.size()), timeoutMs);
+
+        if (pollResult == SOCKET_ERROR) {
+            return SOCKET_ERROR;
+        }
+
+        int seen = 0;
+        for (size_t i = 0; i < m_pollFds.size() && seen < pollResult; i++) {
+            SHORT revents = m_pollFds[i].revents;
+            if (revents == 0) {
+                continue;
+            }
+            seen++;
+
+            if (m_pollFds[i].fd == m_wakeupSocket) {
+                char drain[64];
+                while (recv(m_wakeupSocket, drain, sizeof(drain), 0) > 0) {
+                }
+                continue;
+            }
+
+            IoEvent event;
+            event.socket = m_pollFds[i].fd;
+            event.readable = (revents & POLLRDNORM) != 0;
+            event.writable = (revents & POLLWRNORM) != 0;
+            event.hangup = (revents & (POLLHUP | POLLERR | POLLNVAL)) != 0;
+            events.push_back(event);
+        }
+
+        return static_cast<int>(events.size());
+    }
+
+    void wakeup() override {
+        char signal = 1;
+        sendto(m_wakeupSocket, &signal, 1, 0,
+            (sockaddr*)&m_wakeupAddr, sizeof(m_wakeupAddr));
+    }
+
+    const char* getBackendName() const override {
+        return "WSAPoll";
+    }
+};
+
+unique_ptr<EventLoop> EventLoop::create() {
+    return make_unique<WSAPollEventLoop>();
+}
+
+#else
+
+// ============================================================================
+// EPOLL BACKEND (Linux)
+// ============================================================================
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+class EpollEventLoop : public EventLoop {
+private:
+    int m_epollFd;
+    int m_wakeupFd;
+    vector<epoll_event> m_readyEvents;
+
+    bool control(int operation, SOCKET socket, uint32_t events) {
+        epoll_event event = {};
+        event.events = events;
+        event.data.fd = socket;
+        return epoll_ctl(m_epollFd, operation, socket, &event) == 0;
+    }
+
+public:
+    EpollEventLoop()
+        : m_epollFd(epoll_create1(EPOLL_CLOEXEC))
+        , m_wakeupFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+        , m_readyEvents(1024) {
+        if (m_epollFd < 0 || m_wakeupFd < 0) {
+            LOG_ERROR("[ERROR] epoll setup failed: " << errno);
+            return;
+        }
+        control(EPOLL_CTL_ADD, m_wakeupFd, EPOLLIN);
+    }
+
+    ~EpollEventLoop() override {
+        if (m_wakeupFd >= 0) {
+            close(m_wakeupFd);
+        }
+        if (m_epollFd >= 0) {
+            close(m_epollFd);
+        }
+    }
+
+    bool addSocket(SOCKET socket) override {
+        if (!control(EPOLL_CTL_ADD, socket, EPOLLIN | EPOLLRDHUP | EPOLLET)) {
+            LOG_ERROR("[ERROR] epoll_ctl ADD failed for " << socket
+                << ": " << errno);
+            return false;
+        }
+        return true;
+    }
+
+    void removeSocket(SOCKET socket) override {
+        // The kernel drops closed descriptors on its own; this is only
+        // needed when a socket is removed before being closed.
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, socket, nullptr);
+    }
+
+    void setWriteInterest(SOCKET socket, bool enabled) override {
+        // Re-arming with EPOLL_CTL_MOD also reports EPOLLOUT straight away
+        // if the socket already became writable in the meantime
+        uint32_t events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        if (enabled) {
+            events |= EPOLLOUT;
+        }
+        control(EPOLL_CTL_MOD, socket, events);
+    }
+
+    int wait(vector<IoEvent>& events, int timeoutMs) override {
+        events.clear();
+
+        int readyCount = epoll_wait(m_epollFd, m_readyEvents.data(),
+            static_cast<int>(m_readyEvents.size()), timeoutMs);
+
+        if (readyCount < 0) {
+            return (errno == EINTR) ? 0 : SOCKET_ERROR;
+        }
+
+        for (int i = 0; i < readyCount; i++) {
+            uint32_t flags = m_readyEvents[i].events;
+
+            if (m_readyEvents[i].data.fd == m_wakeupFd) {
+                uint64_t counter;
+                while (read(m_wakeupFd, &counter, sizeof(counter)) > 0) {
+                }
+                continue;
+            }
+
+            IoEvent event;
+            event.socket = m_readyEvents[i].data.fd;
+            event.readable = (flags & EPOLLIN) != 0;
+            event.writable = (flags & EPOLLOUT) != 0;
+            event.hangup = (flags & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0;
+            events.push_back(event);
+        }
+
+        // Grow the ready list when it was saturated so large wakeups
+        // are collected in a single call next time
+        if (readyCount == static_cast<int>(m_readyEvents.size())) {
+            m_readyEvents.resize(m_readyEvents.size() * 2);
+        }
+
+        return static_cast<int>(events.size());
+    }
+
+    void wakeup() override {
+        uint64_t one = 1;
+        ssize_t written = write(m_wakeupFd, &one, sizeof(one));
+        (void)written;
+    }
+
+    const char* getBackendName() const override {
+        return "epoll";
+    }
+};
+
+unique_ptr<EventLoop> EventLoop::create() {
+    return make_unique<EpollEventLoop>();
+}
+
+#endif
\ No newline at end of file
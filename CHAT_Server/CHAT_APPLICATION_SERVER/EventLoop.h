@@ -0,0 +1,45 @@
+#pragma once
+#include "Common.h"
+
+// Readiness of a single socket as reported by EventLoop::wait
+struct IoEvent {
+    SOCKET socket;
+    bool readable;
+    bool writable;
+    bool hangup;
+};
+
+// Socket readiness notifier used by the accept/read loop.
+// Windows uses WSAPoll, Linux uses edge-triggered epoll. Because the
+// epoll backend only reports transitions, callers must keep calling
+// accept()/recv()/send() on a ready socket until it would block.
+class EventLoop {
+private:
+    vector<SOCKET> m_flushRequests;
+    mutex m_flushMutex;
+
+public:
+    virtual ~EventLoop() {}
+
+    // Socket registration (owning thread only)
+    virtual bool addSocket(SOCKET socket) = 0;
+    virtual void removeSocket(SOCKET socket) = 0;
+    virtual void setWriteInterest(SOCKET socket, bool enabled) = 0;
+
+    // Waits up to timeoutMs and fills events with the ready sockets only.
+    // Returns the number of events, or SOCKET_ERROR on failure.
+    virtual int wait(vector<IoEvent>& events, int timeoutMs) = 0;
+
+    // Interrupts a wait() in progress. Safe to call from any thread.
+    virtual void wakeup() = 0;
+
+    virtual const char* getBackendName() const = 0;
+
+    // Asks the owning thread to flush a socket's outbound queue.
+    // Safe to call from any thread.
+    void requestFlush(SOCKET socket);
+    void takeFlushRequests(vector<SOCKET>& sockets);
+
+    // Creates the native backend for the current platform
+    static unique_ptr<EventLoop> create();
+};
\ No newline at end of file
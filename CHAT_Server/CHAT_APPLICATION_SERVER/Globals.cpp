@@ -1,14 +1,15 @@
 #include "Globals.h"
+#include "ChatRoom.h"
 
 // Define global variables
-map<string, shared_ptr<ChatRoom>> g_chatRooms;
-mutex g_chatRoomsMutex;
+ShardedRegistry<Symbol, shared_ptr<ChatRoom>> g_chatRooms(LockRank::RoomRegistry);
 
-map<SOCKET, ClientInfo> g_clients;
-mutex g_clientsMutex;
+ShardedRegistry<SOCKET, ClientInfo> g_clients(LockRank::ClientRegistry);
+ShardedRegistry<Symbol, SOCKET> g_usernames(LockRank::UsernameIndex);
 
-queue<Message> g_messageQueue;
-mutex g_queueMutex;
-condition_variable g_messageCV;
+ShardedRegistry<SOCKET, shared_ptr<Connection>> g_connections(LockRank::ConnectionRegistry);
+atomic<int> g_activeConnections(0);
+
+vector<unique_ptr<MessageShard>> g_messageShards;
 
 atomic<bool> g_shutdownRequested(false);
\ No newline at end of file
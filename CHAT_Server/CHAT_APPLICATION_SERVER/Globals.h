@@ -3,19 +3,36 @@
 #include "ClientInfo.h"
 #include "Message.h"
 #include "Database.h"
+#include "Connection.h"
+#include "MessageShard.h"
+#include "ShardedRegistry.h"
+#include "SymbolTable.h"
 
-// Global map of all chat rooms, keyed by Room ID
-extern map<string, shared_ptr<ChatRoom>> g_chatRooms;
-extern mutex g_chatRoomsMutex;
+// Global registry of all chat rooms, keyed by Room ID. Handlers take a
+// shared_ptr copy and work on the room without holding the registry.
+extern ShardedRegistry<Symbol, shared_ptr<ChatRoom>> g_chatRooms;
 
-// Global map of all connected clients, keyed by Socket
-extern map<SOCKET, ClientInfo> g_clients;
-extern mutex g_clientsMutex;
+// Global registry of all connected clients, keyed by Socket
+extern ShardedRegistry<SOCKET, ClientInfo> g_clients;
 
-// Global message queue for the broadcaster thread
-extern queue<Message> g_messageQueue;
-extern mutex g_queueMutex;
-extern condition_variable g_messageCV;
+// Username -> socket index over g_clients. A name is claimed here with
+// tryInsert before it is stored in ClientInfo, which makes SETNAME's
+// uniqueness check atomic and name lookups O(1).
+extern ShardedRegistry<Symbol, SOCKET> g_usernames;
+
+// Global registry of client transports, keyed by Socket. Used to queue
+// outbound data from any thread; the shard lock is only held to copy the
+// pointer, never while sending. Room fan-out doesn't use it at all: rooms
+// keep their members' connections.
+extern ShardedRegistry<SOCKET, shared_ptr<Connection>> g_connections;
+
+// Accepted sockets, including those still waiting for admission. Checked
+// against --max-connections before a new socket is taken on.
+extern atomic<int> g_activeConnections;
+
+// Broadcaster shards, one queue per worker thread. Created before the
+// workers start and never resized while they run.
+extern vector<unique_ptr<MessageShard>> g_messageShards;
 
 // Global shutdown flag
 extern atomic<bool> g_shutdownRequested;
\ No newline at end of file
@@ -0,0 +1,29 @@
+#include "LockOrder.h"
+
+#ifndef NDEBUG
+
+#include <cstdlib>
+
+// Ranks held by the current thread, in acquisition order
+static thread_local vector<LockRank> t_heldRanks;
+
+void noteLockAcquired(LockRank rank) {
+    if (!t_heldRanks.empty() && t_heldRanks.back() >= rank) {
+        cout << "[FATAL] Lock order violation: acquiring rank "
+            << static_cast<int>(rank) << " while holding rank "
+            << static_cast<int>(t_heldRanks.back()) << endl;
+        abort();
+    }
+    t_heldRanks.push_back(rank);
+}
+
+void noteLockReleased(LockRank rank) {
+    for (auto it = t_heldRanks.rbegin(); it != t_heldRanks.rend(); ++it) {
+        if (*it == rank) {
+            t_heldRanks.erase(next(it).base());
+            return;
+        }
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include "Common.h"
+#include <shared_mutex>
+
+// Global lock hierarchy. A thread may only acquire a lock whose rank is
+// strictly higher than every lock it already holds, which rules out
+// lock-order deadlocks between the registries and rooms:
+//
+//   UsernameIndex shard  ->  ClientRegistry shard  ->  RoomRegistry shard
+//     ->  ChatRoom  ->  ConnectionRegistry shard  ->  SymbolTable
+//
+// The registries never call out while holding a shard lock except into
+// the callback passed to them, so in practice handlers take at most one
+// registry shard at a time plus, inside a room-registry callback, the
+// room itself. Debug builds check the order on every acquisition and
+// abort on a violation; release builds (NDEBUG) compile the checks out.
+enum class LockRank : int {
+    UsernameIndex = 5,
+    ClientRegistry = 10,
+    RoomRegistry = 20,
+    Room = 30,
+    ConnectionRegistry = 35,    // Lookups only; sends may happen under any lock above
+    SymbolTable = 40    // Leaf; interning may happen under any other lock
+};
+
+#ifdef NDEBUG
+inline void noteLockAcquired(LockRank) {}
+inline void noteLockReleased(LockRank) {}
+#else
+void noteLockAcquired(LockRank rank);
+void noteLockReleased(LockRank rank);
+#endif
+
+// std::mutex that takes part in the lock hierarchy
+class RankedMutex {
+private:
+    mutex m_mutex;
+    LockRank m_rank;
+
+public:
+    explicit RankedMutex(LockRank rank) : m_rank(rank) {}
+
+    void lock() {
+        noteLockAcquired(m_rank);
+        m_mutex.lock();
+    }
+
+    void unlock() {
+        m_mutex.unlock();
+        noteLockReleased(m_rank);
+    }
+};
+
+// std::shared_mutex that takes part in the lock hierarchy
+class RankedSharedMutex {
+private:
+    shared_mutex m_mutex;
+    LockRank m_rank;
+
+public:
+    explicit RankedSharedMutex(LockRank rank) : m_rank(rank) {}
+
+    void lock() {
+        noteLockAcquired(m_rank);
+        m_mutex.lock();
+    }
+
+    void unlock() {
+        m_mutex.unlock();
+        noteLockReleased(m_rank);
+    }
+
+    void lock_shared() {
+        noteLockAcquired(m_rank);
+        m_mutex.lock_shared();
+    }
+
+    void unlock_shared() {
+        m_mutex.unlock_shared();
+        noteLockReleased(m_rank);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "Logger.h"
+#include <algorithm>
+
+Logger g_logger;
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug:
+        return "debug";
+    case LogLevel::Info:
+        return "info";
+    case LogLevel::Warn:
+        return "warn";
+    case LogLevel::Error:
+        return "error";
+    }
+    return "unknown";
+}
+
+bool parseLogLevel(const string& text, LogLevel& level) {
+    for (LogLevel candidate : { LogLevel::Debug, LogLevel::Info, LogLevel::Warn, LogLevel::Error }) {
+        if (text == logLevelName(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int64_t steadyNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ============================================================================
+// LOGGER
+// ============================================================================
+
+Logger::Logger()
+    : m_level(static_cast<int>(LogLevel::Info))
+    , m_running(false)
+    , m_out(&cout)
+    , m_stopping(false)
+    , m_flushRequested(0)
+    , m_flushCompleted(0)
+    , m_written(0)
+    , m_dropped(0)
+    , m_droppedReported(0) {
+}
+
+Logger::~Logger() {
+    stop();
+}
+
+void Logger::setLevel(LogLevel level) {
+    m_level.store(static_cast<int>(level), memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() const {
+    return static_cast<LogLevel>(m_level.load(memory_order_relaxed));
+}
+
+void Logger::start(ostream& out) {
+    if (m_writer.joinable()) {
+        return;
+    }
+
+    m_out = &out;
+    m_stopping = false;
+    m_writer = thread(&Logger::run, this);
+    m_running = true;
+}
+
+void Logger::stop() {
+    if (!m_writer.joinable()) {
+        return;
+    }
+
+    // New lines go straight out from here on; the writer's last pass picks
+    // up whatever was queued before
+    m_running = false;
+    {
+        lock_guard<mutex> lock(m_writerMutex);
+        m_stopping = true;
+    }
+    m_writerCondition.notify_all();
+    m_writer.join();
+}
+
+void Logger::flush() {
+    if (!m_running) {
+        return;
+    }
+
+    unique_lock<mutex> lock(m_writerMutex);
+    uint64_t target = ++m_flushRequested;
+    m_writerCondition.notify_all();
+    m_writerCondition.wait(lock, [this, target] {
+        return m_flushCompleted >= target || m_stopping;
+        });
+}
+
+// The buffer pointer is cached per thread; the logger owns the buffer so
+// lines queued just before a thread exits are still written. Short-lived
+// threads (room cleanups) would otherwise leave a ring behind each.
+Logger::ThreadBuffer& Logger::threadBuffer() {
+    thread_local BufferLease t_lease;
+    if (!t_lease.buffer) {
+        lock_guard<mutex> lock(m_buffersMutex);
+        m_buffers.push_back(make_unique<ThreadBuffer>());
+        t_lease.buffer = m_buffers.back().get();
+    }
+    return *t_lease.buffer;
+}
+
+void Logger::write(const string& text) {
+    if (!m_running) {
+        lock_guard<mutex> lock(m_outputMutex);
+        *m_out << text << '\n';
+        m_out->flush();
+        m_written.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+
+    // Never block the caller: a full buffer means the console can't keep
+    // up, and the writer reports how many lines were lost
+    if (!threadBuffer().records.tryPush({ steadyNanos(), text })) {
+        m_dropped.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+void Logger::run() {
+    vector<LogRecord> batch;
+    unique_lock<mutex> lock(m_writerMutex);
+
+    while (true) {
+        m_writerCondition.wait_for(lock, chrono::milliseconds(LOG_FLUSH_MS), [this] {
+            return m_stopping || m_flushRequested > m_flushCompleted;
+            });
+        bool stopping = m_stopping;
+        uint64_t requested = m_flushRequested;
+
+        lock.unlock();
+        drain(batch);
+        lock.lock();
+
+        m_flushCompleted = requested;
+        m_writerCondition.notify_all();
+        if (stopping) {
+            break;
+        }
+    }
+}
+
+// Takes at most one ring's worth from each thread per pass, so a thread
+// logging nonstop can't keep the writer from finishing
+void Logger::drain(vector<LogRecord>& batch) {
+    batch.clear();
+    {
+        lock_guard<mutex> lock(m_buffersMutex);
+        for (auto it = m_buffers.begin(); it != m_buffers.end();) {
+            // Read before popping: a retired thread pushes nothing more, so
+            // one pass of a whole ring's worth leaves its buffer empty
+            bool retired = (*it)->retired.load(memory_order_acquire);
+            (*it)->records.popBatch(batch, LOG_BUFFER_CAPACITY);
+
+            if (retired) {
+                it = m_buffers.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    // Each thread's lines are already in order; merge them by time
+    stable_sort(batch.begin(), batch.end(), [](const LogRecord& a, const LogRecord& b) {
+        return a.timeNanos < b.timeNanos;
+        });
+
+    uint64_t dropped = m_dropped.load(memory_order_relaxed);
+    if (batch.empty() && dropped == m_droppedReported) {
+        return;
+    }
+
+    lock_guard<mutex> lock(m_outputMutex);
+    for (const LogRecord& record : batch) {
+        *m_out << record.text << '\n';
+    }
+    if (dropped != m_droppedReported) {
+        *m_out << "[LOG] " << (dropped - m_droppedReported)
+            << " lines dropped, log buffers were full" << '\n';
+        m_droppedReported = dropped;
+    }
+    m_out->flush();
+    m_written.fetch_add(batch.size(), memory_order_relaxed);
+}
+
+uint64_t Logger::getWrittenLines() const {
+    return m_written.load(memory_order_relaxed);
+}
+
+uint64_t Logger::getDroppedLines() const {
+    return m_dropped.load(memory_order_relaxed);
+}
+
+// ============================================================================
+// LOG LINE
+// ============================================================================
+
+namespace {
+
+// Appends to a string that keeps its capacity between lines
+class LineBuffer : public streambuf {
+public:
+    string text;
+
+protected:
+    int overflow(int c) override {
+        if (c != EOF) {
+            text.push_back(static_cast<char>(c));
+        }
+        return c;
+    }
+
+    streamsize xsputn(const char* data, streamsize count) override {
+        text.append(data, static_cast<size_t>(count));
+        return count;
+    }
+};
+
+struct ThreadFormatter {
+    LineBuffer buffer;
+    ostream stream;
+
+    ThreadFormatter() : stream(&buffer) {}
+};
+
+thread_local ThreadFormatter t_formatter;
+
+} // namespace
+
+LogLine::LogLine()
+    : m_stream(t_formatter.stream) {
+    t_formatter.buffer.text.clear();
+}
+
+LogLine::~LogLine() {
+    g_logger.write(t_formatter.buffer.text);
+}
+
+// ============================================================================
+// LOG THROTTLE
+// ============================================================================
+
+LogThrottle::LogThrottle()
+    : m_second(0)
+    , m_linesThisSecond(0)
+    , m_suppressed(0) {
+}
+
+bool LogThrottle::allow(uint64_t& suppressed) {
+    int64_t now = chrono::duration_cast<chrono::seconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+
+    // Whoever sees the new second first opens it; a race here only lets a
+    // line or two more through
+    int64_t second = m_second.load(memory_order_relaxed);
+    if (second != now && m_second.compare_exchange_strong(second, now, memory_order_relaxed)) {
+        m_linesThisSecond.store(0, memory_order_relaxed);
+    }
+
+    if (m_linesThisSecond.fetch_add(1, memory_order_relaxed) >= LOG_REPEAT_LIMIT) {
+        m_suppressed.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    suppressed = m_suppressed.exchange(0, memory_order_relaxed);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#pragma once
+#include "Common.h"
+#include "MpscQueue.h"
+
+// ============================================================================
+// LOGGING
+// ============================================================================
+// Server code logs through the LOG_* macros instead of cout:
+//
+//     LOG_INFO("[CMD] Client " << clientSocket << " set name: " << name);
+//
+// A line below the current level costs one relaxed load; the arguments
+// are not even evaluated. An enabled line is formatted into a reused
+// per-thread buffer and pushed onto that thread's own lock-free queue. A
+// background writer drains every queue, puts the lines back in time order
+// and writes them with one flush per pass, so no server thread waits on
+// the console. LOG_WARN and LOG_ERROR are also throttled per call site,
+// so an error repeated in a loop can't flood the log.
+//
+// Until start() and after stop() lines are written synchronously, which
+// keeps startup errors and tools that never start the writer working.
+
+enum class LogLevel {
+    Debug,      // Per-message traffic ([BROADCAST], [PM], read-only commands)
+    Info,       // Connections, state changes, thread lifecycle
+    Warn,
+    Error
+};
+
+const char* logLevelName(LogLevel level);
+
+// Parses "debug", "info", "warn" or "error". Returns false otherwise.
+bool parseLogLevel(const string& text, LogLevel& level);
+
+class Logger {
+private:
+    struct LogRecord {
+        int64_t timeNanos;
+        string text;
+    };
+
+    // One per logging thread, created on its first line; the thread's only
+    // producer is itself. Marked retired when the thread exits, and freed
+    // by the writer once everything queued in it has been written.
+    struct ThreadBuffer {
+        MpscQueue<LogRecord> records;
+        atomic<bool> retired;
+
+        ThreadBuffer() : records(LOG_BUFFER_CAPACITY), retired(false) {}
+    };
+
+    // The calling thread's handle on its buffer; retires it on thread exit
+    struct BufferLease {
+        ThreadBuffer* buffer = nullptr;
+
+        ~BufferLease() {
+            if (buffer) {
+                buffer->retired.store(true, memory_order_release);
+            }
+        }
+    };
+
+    atomic<int> m_level;
+    atomic<bool> m_running;
+    ostream* m_out;
+
+    mutex m_buffersMutex;
+    vector<unique_ptr<ThreadBuffer>> m_buffers;
+
+    thread m_writer;
+    mutex m_writerMutex;
+    condition_variable m_writerCondition;
+    bool m_stopping;
+    uint64_t m_flushRequested;
+    uint64_t m_flushCompleted;
+
+    mutex m_outputMutex;            // Writer pass vs. synchronous writes
+    atomic<uint64_t> m_written;
+    atomic<uint64_t> m_dropped;
+    uint64_t m_droppedReported;
+
+    ThreadBuffer& threadBuffer();
+    void run();
+    void drain(vector<LogRecord>& batch);
+
+public:
+    Logger();
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    bool isEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= m_level.load(memory_order_relaxed);
+    }
+
+    // Takes effect immediately on every thread
+    void setLevel(LogLevel level);
+    LogLevel getLevel() const;
+
+    // Starts the background writer; lines go to out until stop()
+    void start(ostream& out);
+
+    // Writes everything queued so far, then stops the writer. Safe to call
+    // more than once.
+    void stop();
+
+    // Blocks until every line logged before the call has been written
+    void flush();
+
+    // Called by LogLine; text is one line without the newline
+    void write(const string& text);
+
+    uint64_t getWrittenLines() const;
+    uint64_t getDroppedLines() const;
+};
+
+extern Logger g_logger;
+
+// Builds one line in the calling thread's reusable buffer and hands it to
+// g_logger when it goes out of scope
+class LogLine {
+private:
+    ostream& m_stream;
+
+public:
+    LogLine();
+    ~LogLine();
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    template <typename T>
+    LogLine& operator<<(const T& value) {
+        m_stream << value;
+        return *this;
+    }
+};
+
+// Lets the first LOG_REPEAT_LIMIT lines from one call site through each
+// second and counts the rest, so the next line that gets through can say
+// how many were skipped
+class LogThrottle {
+private:
+    atomic<int64_t> m_second;
+    atomic<uint32_t> m_linesThisSecond;
+    atomic<uint64_t> m_suppressed;
+
+public:
+    LogThrottle();
+
+    // True if this line should be written; suppressed is set to the lines
+    // skipped since the last one that was
+    bool allow(uint64_t& suppressed);
+};
+
+#define LOG_AT(level, ...) \
+    do { \
+        if (g_logger.isEnabled(level)) { \
+            LogLine logLine; \
+            logLine << __VA_ARGS__; \
+        } \
+    } while (0)
+
+#define LOG_THROTTLED(level, ...) \
+    do { \
+        if (g_logger.isEnabled(level)) { \
+            static LogThrottle s_logThrottle; \
+            uint64_t logSuppressed = 0; \
+            if (s_logThrottle.allow(logSuppressed)) { \
+                LogLine logLine; \
+                logLine << __VA_ARGS__; \
+                if (logSuppressed > 0) { \
+                    logLine << " (" << logSuppressed << " similar lines suppressed)"; \
+                } \
+            } \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...) LOG_THROTTLED(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_THROTTLED(LogLevel::Error, __VA_ARGS__)
\ No newline at end of file
@@ -3,24 +3,23 @@
 Message::Message()
     : m_senderSocket(INVALID_SOCKET)
     , m_content("")
-    , m_roomId("")
-    , m_senderName("")
-    , m_isPrivate(false)
-    , m_recipientName("") {
+    , m_isPrivate(false) {
 }
 
 // Getters
 SOCKET Message::getSenderSocket() const { return m_senderSocket; }
-string Message::getContent() const { return m_content; }
-string Message::getRoomId() const { return m_roomId; }
-string Message::getSenderName() const { return m_senderName; }
+const string& Message::getContent() const { return m_content; }
+const SymbolRef& Message::getRoomId() const { return m_roomId; }
+const SymbolRef& Message::getSenderName() const { return m_senderName; }
 bool Message::isPrivate() const { return m_isPrivate; }
-string Message::getRecipientName() const { return m_recipientName; }
+const SymbolRef& Message::getRecipientName() const { return m_recipientName; }
 
 // Setters
 void Message::setSenderSocket(SOCKET socket) { m_senderSocket = socket; }
-void Message::setContent(const string& content) { m_content = content; }
-void Message::setRoomId(const string& roomId) { m_roomId = roomId; }
-void Message::setSenderName(const string& name) { m_senderName = name; }
+void Message::setContent(string content) { m_content = move(content); }
+void Message::setRoomId(SymbolRef roomId) { m_roomId = move(roomId); }
+void Message::setSenderName(SymbolRef name) { m_senderName = move(name); }
 void Message::setIsPrivate(bool isPrivate) { m_isPrivate = isPrivate; }
-void Message::setRecipientName(const string& name) { m_recipientName = name; }
\ No newline at end of file
+void Message::setRecipientName(SymbolRef name) { m_recipientName = move(name); }
+
+string Message::takeContent() { return move(m_content); }
\ No newline at end of file
@@ -1,31 +1,35 @@
 #pragma once
 #include "Common.h"
+#include "SymbolTable.h"
 
 class Message {
 private:
     SOCKET m_senderSocket;
     string m_content;
-    string m_roomId;
-    string m_senderName;
+    SymbolRef m_roomId;
+    SymbolRef m_senderName;
     bool m_isPrivate;
-    string m_recipientName;
+    SymbolRef m_recipientName;
 
 public:
     Message();
 
     // Getters
     SOCKET getSenderSocket() const;
-    string getContent() const;
-    string getRoomId() const;
-    string getSenderName() const;
+    const string& getContent() const;
+    const SymbolRef& getRoomId() const;
+    const SymbolRef& getSenderName() const;
     bool isPrivate() const;
-    string getRecipientName() const;
+    const SymbolRef& getRecipientName() const;
 
     // Setters
     void setSenderSocket(SOCKET socket);
-    void setContent(const string& content);
-    void setRoomId(const string& roomId);
-    void setSenderName(const string& name);
+    void setContent(string content);
+    void setRoomId(SymbolRef roomId);
+    void setSenderName(SymbolRef name);
     void setIsPrivate(bool isPrivate);
-    void setRecipientName(const string& name);
+    void setRecipientName(SymbolRef name);
+
+    // Moves the content out, for the last consumer of the message
+    string takeContent();
 };
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "MessageShard.h"
+#include "Globals.h"
+
+MessageShard::MessageShard()
+    : m_messages(MESSAGE_SHARD_CAPACITY)
+    , m_sleeping(false)
+    , m_peakDepth(0)
+    , m_totalMessages(0)
+    , m_droppedMessages(0)
+    , m_wakeups(0) {
+}
+
+bool MessageShard::push(Message message) {
+    if (!m_messages.tryPush(move(message))) {
+        m_droppedMessages.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    m_totalMessages.fetch_add(1, memory_order_relaxed);
+
+    size_t depth = m_messages.sizeApprox();
+    size_t peak = m_peakDepth.load(memory_order_relaxed);
+    while (depth > peak &&
+        !m_peakDepth.compare_exchange_weak(peak, depth, memory_order_relaxed)) {
+    }
+
+    // Only the producer that flips the flag pays for the notify. Taking the
+    // mutex orders it against the worker's check-then-wait.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (m_sleeping.load() && m_sleeping.exchange(false)) {
+        lock_guard<mutex> lock(m_wakeMutex);
+        m_wakeups.fetch_add(1, memory_order_relaxed);
+        m_wakeCV.notify_one();
+    }
+    return true;
+}
+
+size_t MessageShard::waitAndPopBatch(vector<Message>& batch, size_t maxCount,
+    chrono::milliseconds timeout) {
+    size_t taken = m_messages.popBatch(batch, maxCount);
+    if (taken > 0) {
+        return taken;
+    }
+
+    {
+        unique_lock<mutex> lock(m_wakeMutex);
+
+        // Announce the sleep before the final emptiness check; a producer
+        // publishing after this point is guaranteed to see the flag
+        m_sleeping.store(true);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (m_messages.sizeApprox() == 0 && !g_shutdownRequested) {
+            m_wakeCV.wait_for(lock, timeout, [this] {
+                return !m_sleeping.load() || g_shutdownRequested;
+                });
+        }
+        m_sleeping.store(false);
+    }
+
+    return m_messages.popBatch(batch, maxCount);
+}
+
+void MessageShard::notifyAll() {
+    lock_guard<mutex> lock(m_wakeMutex);
+    m_wakeCV.notify_all();
+}
+
+size_t MessageShard::getDepth() const {
+    return m_messages.sizeApprox();
+}
+
+size_t MessageShard::getPeakDepth() const {
+    return m_peakDepth;
+}
+
+uint64_t MessageShard::getTotalMessages() const {
+    return m_totalMessages;
+}
+
+uint64_t MessageShard::getDroppedMessages() const {
+    return m_droppedMessages;
+}
+
+uint64_t MessageShard::getWakeups() const {
+    return m_wakeups;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include "Common.h"
+#include "Message.h"
+#include "MpscQueue.h"
+
+// Queue feeding one broadcaster worker. Messages are routed to a shard by
+// room ID hash, so every message of a room is delivered by the same thread
+// and keeps its order.
+//
+// Producers push into a lock-free ring and only touch the mutex/condition
+// variable when the worker has announced it is going to sleep, so a burst
+// of messages costs one wakeup and is drained in a single batch.
+class MessageShard {
+private:
+    MpscQueue<Message> m_messages;
+
+    // Set by the worker right before it waits; the first producer to see it
+    // clears it and signals. Everyone else skips the notify entirely.
+    atomic<bool> m_sleeping;
+    mutex m_wakeMutex;
+    condition_variable m_wakeCV;
+
+    atomic<size_t> m_peakDepth;
+    atomic<uint64_t> m_totalMessages;
+    atomic<uint64_t> m_droppedMessages;
+    atomic<uint64_t> m_wakeups;
+
+public:
+    MessageShard();
+
+    // Any thread. Returns false if the shard is full; the message is dropped.
+    bool push(Message message);
+
+    // Worker thread only. Waits up to timeout for messages, then moves up to
+    // maxCount of them into batch. Returns the number taken.
+    size_t waitAndPopBatch(vector<Message>& batch, size_t maxCount, chrono::milliseconds timeout);
+
+    // Wakes the worker so it can observe shutdown
+    void notifyAll();
+
+    // Queue-depth metrics
+    size_t getDepth() const;
+    size_t getPeakDepth() const;
+    uint64_t getTotalMessages() const;
+    uint64_t getDroppedMessages() const;
+    uint64_t getWakeups() const;
+};
\ No newline at end of file
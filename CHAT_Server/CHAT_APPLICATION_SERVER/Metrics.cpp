@@ -0,0 +1,279 @@
+#include "Metrics.h"
+#include "Globals.h"
+#include "PersistenceWriter.h"
+#include "Logger.h"
+
+// Registry first: g_serverMetrics registers into it while being constructed
+MetricsRegistry g_metrics;
+ServerMetrics g_serverMetrics;
+
+// ============================================================================
+// COUNTER
+// ============================================================================
+
+// Each thread sticks to one stripe, handed out round-robin on first use
+static size_t stripeForThisThread() {
+    static atomic<size_t> s_nextStripe(0);
+    thread_local size_t t_stripe =
+        s_nextStripe.fetch_add(1, memory_order_relaxed) % METRIC_COUNTER_STRIPES;
+    return t_stripe;
+}
+
+void Counter::add(uint64_t amount) {
+    m_stripes[stripeForThisThread()].value.fetch_add(amount, memory_order_relaxed);
+}
+
+uint64_t Counter::get() const {
+    uint64_t total = 0;
+    for (const Stripe& stripe : m_stripes) {
+        total += stripe.value.load(memory_order_relaxed);
+    }
+    return total;
+}
+
+// ============================================================================
+// HISTOGRAM
+// ============================================================================
+
+static int highestBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+Histogram::Histogram()
+    : m_count(0)
+    , m_sumNanos(0) {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, memory_order_relaxed);
+    }
+}
+
+// Values below SUB_BUCKETS get a bucket each; above that, the exponent
+// picks the group and the next SUB_BUCKET_BITS bits the sub-bucket
+int Histogram::bucketIndex(uint64_t nanos) {
+    if (nanos < SUB_BUCKETS) {
+        return static_cast<int>(nanos);
+    }
+
+    nanos = min(nanos, (uint64_t(1) << MAX_EXPONENT) - 1);
+    int exponent = highestBit(nanos);
+    int shift = exponent - SUB_BUCKET_BITS;
+    int group = exponent - SUB_BUCKET_BITS + 1;
+    return group * SUB_BUCKETS + static_cast<int>((nanos >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint64_t Histogram::bucketLimit(int index) {
+    int group = index / SUB_BUCKETS;
+    uint64_t subBucket = static_cast<uint64_t>(index % SUB_BUCKETS);
+    if (group == 0) {
+        return subBucket + 1;
+    }
+
+    int shift = group - 1;
+    return (SUB_BUCKETS + subBucket + 1) << shift;
+}
+
+void Histogram::record(chrono::nanoseconds duration) {
+    uint64_t nanos = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+    m_buckets[bucketIndex(nanos)].fetch_add(1, memory_order_relaxed);
+    m_count.fetch_add(1, memory_order_relaxed);
+    m_sumNanos.fetch_add(nanos, memory_order_relaxed);
+}
+
+uint64_t Histogram::countBelow(uint64_t limitNanos) const {
+    uint64_t total = 0;
+    for (int i = 0; i < BUCKET_COUNT && bucketLimit(i) <= limitNanos; i++) {
+        total += m_buckets[i].load(memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Histogram::getCount() const {
+    return m_count.load(memory_order_relaxed);
+}
+
+uint64_t Histogram::getSumNanos() const {
+    return m_sumNanos.load(memory_order_relaxed);
+}
+
+// ============================================================================
+// REGISTRY
+// ============================================================================
+
+Counter& MetricsRegistry::addCounter(const string& name, const string& help,
+    const string& labels) {
+    lock_guard<mutex> lock(m_mutex);
+    m_counters.push_back(make_unique<Counter>());
+    m_entries.push_back({ Kind::Counter, name, help, labels, m_counters.back().get(), nullptr, nullptr });
+    return *m_counters.back();
+}
+
+Histogram& MetricsRegistry::addHistogram(const string& name, const string& help,
+    const string& labels) {
+    lock_guard<mutex> lock(m_mutex);
+    m_histograms.push_back(make_unique<Histogram>());
+    m_entries.push_back({ Kind::Histogram, name, help, labels, nullptr, m_histograms.back().get(), nullptr });
+    return *m_histograms.back();
+}
+
+void MetricsRegistry::addCounterFunction(const string& name, const string& help,
+    function<double()> fn) {
+    lock_guard<mutex> lock(m_mutex);
+    m_entries.push_back({ Kind::CounterFunction, name, help, "", nullptr, nullptr, move(fn) });
+}
+
+void MetricsRegistry::addGauge(const string& name, const string& help, function<double()> fn) {
+    lock_guard<mutex> lock(m_mutex);
+    m_entries.push_back({ Kind::Gauge, name, help, "", nullptr, nullptr, move(fn) });
+}
+
+static string formatValue(double value) {
+    ostringstream stream;
+    stream.precision(10);
+    stream << value;
+    return stream.str();
+}
+
+// Buckets are exported at powers of two from 256 ns to about 34 s; the
+// finer internal buckets only matter for accuracy, not for the scrape
+void MetricsRegistry::renderHistogram(string& out, const Entry& entry) {
+    const Histogram& histogram = *entry.histogram;
+    string labelPrefix = entry.labels.empty() ? "" : entry.labels + ",";
+
+    for (int exponent = 8; exponent <= 35; exponent++) {
+        uint64_t limit = uint64_t(1) << exponent;
+        out += entry.name + "_bucket{" + labelPrefix + "le=\"" + formatValue(limit / 1e9) +
+            "\"} " + to_string(histogram.countBelow(limit)) + "\n";
+    }
+
+    uint64_t count = histogram.getCount();
+    string labels = entry.labels.empty() ? "" : "{" + entry.labels + "}";
+    out += entry.name + "_bucket{" + labelPrefix + "le=\"+Inf\"} " + to_string(count) + "\n";
+    out += entry.name + "_sum" + labels + " " + formatValue(histogram.getSumNanos() / 1e9) + "\n";
+    out += entry.name + "_count" + labels + " " + to_string(count) + "\n";
+}
+
+string MetricsRegistry::render() const {
+    lock_guard<mutex> lock(m_mutex);
+    string out;
+    const string* previousName = nullptr;
+
+    for (const Entry& entry : m_entries) {
+        if (!previousName || *previousName != entry.name) {
+            const char* type = "counter";
+            if (entry.kind == Kind::Gauge) {
+                type = "gauge";
+            }
+            else if (entry.kind == Kind::Histogram) {
+                type = "histogram";
+            }
+            out += "# HELP " + entry.name + " " + entry.help + "\n";
+            out += "# TYPE " + entry.name + " " + type + "\n";
+            previousName = &entry.name;
+        }
+
+        string labels = entry.labels.empty() ? "" : "{" + entry.labels + "}";
+        switch (entry.kind) {
+        case Kind::Counter:
+            out += entry.name + labels + " " + to_string(entry.counter->get()) + "\n";
+            break;
+        case Kind::CounterFunction:
+        case Kind::Gauge:
+            out += entry.name + labels + " " + formatValue(entry.sample()) + "\n";
+            break;
+        case Kind::Histogram:
+            renderHistogram(out, entry);
+            break;
+        }
+    }
+    return out;
+}
+
+// ============================================================================
+// SERVER INSTRUMENTS
+// ============================================================================
+
+ServerMetrics::ServerMetrics()
+    : connectionsAccepted(g_metrics.addCounter("chat_connections_accepted_total",
+        "Client connections accepted"))
+    , connectionsRefused(g_metrics.addCounter("chat_connections_refused_total",
+        "Client connections refused because the server was full"))
+    , framesReceived(g_metrics.addCounter("chat_frames_received_total",
+        "Frames received from clients"))
+    , bytesReceived(g_metrics.addCounter("chat_bytes_received_total",
+        "Bytes received from clients"))
+    , framesSent(g_metrics.addCounter("chat_frames_sent_total",
+        "Frames written to client sockets"))
+    , bytesSent(g_metrics.addCounter("chat_bytes_sent_total",
+        "Bytes written to client sockets"))
+    , rateLimitedByClient(g_metrics.addCounter("chat_rate_limited_total",
+        "Chat and private messages dropped by flood limits", "limit=\"client\""))
+    , rateLimitedByRoom(g_metrics.addCounter("chat_rate_limited_total",
+        "Chat and private messages dropped by flood limits", "limit=\"room\""))
+    , broadcastBatch(g_metrics.addHistogram("chat_broadcast_batch_seconds",
+        "Time a broadcaster spends delivering one batch of queued messages"))
+    , dbCommit(g_metrics.addHistogram("chat_db_commit_seconds",
+        "Time to commit one batch of messages to the database")) {
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        m_commandLatency[i] = &g_metrics.addHistogram("chat_command_seconds",
+            "Time to handle a client command",
+            "command=\"" + string(COMMAND_NAMES[i]) + "\"");
+    }
+    m_commandLatency[COMMAND_COUNT] = &g_metrics.addHistogram("chat_command_seconds",
+        "Time to handle a client command", "command=\"other\"");
+}
+
+void registerServerStateMetrics() {
+    g_metrics.addGauge("chat_connections_active", "Open client connections", [] {
+        return static_cast<double>(g_activeConnections.load());
+        });
+    g_metrics.addGauge("chat_clients", "Registered clients", [] {
+        return static_cast<double>(g_clients.size());
+        });
+    g_metrics.addGauge("chat_rooms", "Open chat rooms", [] {
+        return static_cast<double>(g_chatRooms.size());
+        });
+    g_metrics.addGauge("chat_symbols", "Usernames and room IDs currently interned", [] {
+        return static_cast<double>(g_symbols.size());
+        });
+    g_metrics.addGauge("chat_broadcast_queue_depth", "Messages waiting in broadcaster queues", [] {
+        size_t depth = 0;
+        for (const auto& shard : g_messageShards) {
+            depth += shard->getDepth();
+        }
+        return static_cast<double>(depth);
+        });
+    g_metrics.addCounterFunction("chat_broadcast_dropped_total",
+        "Messages dropped because a broadcaster queue was full", [] {
+        uint64_t dropped = 0;
+        for (const auto& shard : g_messageShards) {
+            dropped += shard->getDroppedMessages();
+        }
+        return static_cast<double>(dropped);
+        });
+    g_metrics.addGauge("chat_persistence_queue_depth", "Operations waiting for the database writer", [] {
+        return static_cast<double>(g_persistence->getDepth());
+        });
+    g_metrics.addCounterFunction("chat_db_messages_committed_total", "Messages committed to the database", [] {
+        return static_cast<double>(g_persistence->getCommittedMessages());
+        });
+    g_metrics.addCounterFunction("chat_db_messages_failed_total", "Messages that failed to commit", [] {
+        return static_cast<double>(g_persistence->getFailedMessages());
+        });
+    g_metrics.addCounterFunction("chat_db_stalls_total",
+        "Times a broadcaster blocked on a full persistence queue", [] {
+        return static_cast<double>(g_persistence->getStalls());
+        });
+    g_metrics.addCounterFunction("chat_log_lines_total", "Log lines written", [] {
+        return static_cast<double>(g_logger.getWrittenLines());
+        });
+    g_metrics.addCounterFunction("chat_log_dropped_total",
+        "Log lines dropped because a thread's log buffer was full", [] {
+        return static_cast<double>(g_logger.getDroppedLines());
+        });
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+#include "Common.h"
+#include "CommandTable.h"
+#include <functional>
+
+// ============================================================================
+// METRICS
+// ============================================================================
+// Instruments are updated on the hot paths with relaxed atomic adds only;
+// no lock is taken until the admin endpoint renders them.
+
+// Monotonic counter. Split into cache-line stripes picked per thread, so
+// reactors and broadcasters bumping the same counter don't bounce a line
+// between cores. Reads add the stripes up.
+class Counter {
+private:
+    struct alignas(64) Stripe {
+        atomic<uint64_t> value{ 0 };
+    };
+
+    Stripe m_stripes[METRIC_COUNTER_STRIPES];
+
+public:
+    void add(uint64_t amount = 1);
+    uint64_t get() const;
+};
+
+// Latency histogram with HDR-style log-linear buckets: every power of two
+// is split into 8 linear sub-buckets, so any recorded value is known to
+// within 12.5% from 1 ns up to about 4.9 hours. Recording is one
+// relaxed add on the bucket plus the running count and sum.
+class Histogram {
+public:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 44;
+    static const int BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+private:
+    atomic<uint64_t> m_buckets[BUCKET_COUNT];
+    atomic<uint64_t> m_count;
+    atomic<uint64_t> m_sumNanos;
+
+    static int bucketIndex(uint64_t nanos);
+
+public:
+    Histogram();
+
+    void record(chrono::nanoseconds duration);
+
+    // Exclusive upper bound of a bucket, in nanoseconds
+    static uint64_t bucketLimit(int index);
+
+    // Recorded values below limitNanos (a power of two)
+    uint64_t countBelow(uint64_t limitNanos) const;
+
+    uint64_t getCount() const;
+    uint64_t getSumNanos() const;
+};
+
+// Times a scope into a histogram
+class ScopedTimer {
+private:
+    Histogram& m_histogram;
+    chrono::steady_clock::time_point m_start;
+
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : m_histogram(histogram)
+        , m_start(chrono::steady_clock::now()) {
+    }
+
+    ~ScopedTimer() {
+        m_histogram.record(chrono::steady_clock::now() - m_start);
+    }
+};
+
+// Named instruments, rendered in the Prometheus text format. Counters and
+// histograms are owned here and never move once created; gauges and
+// counters kept elsewhere are sampled through a callback at render time.
+// Registration and rendering share one mutex; updates never touch it.
+class MetricsRegistry {
+private:
+    enum class Kind { Counter, CounterFunction, Gauge, Histogram };
+
+    struct Entry {
+        Kind kind;
+        string name;
+        string help;
+        string labels;      // e.g. command="JOIN", empty for none
+        Counter* counter;
+        Histogram* histogram;
+        function<double()> sample;
+    };
+
+    mutable mutex m_mutex;
+    vector<Entry> m_entries;
+    vector<unique_ptr<Counter>> m_counters;
+    vector<unique_ptr<Histogram>> m_histograms;
+
+    static void renderHistogram(string& out, const Entry& entry);
+
+public:
+    Counter& addCounter(const string& name, const string& help, const string& labels = "");
+    Histogram& addHistogram(const string& name, const string& help, const string& labels = "");
+
+    // Sampled on every render; fn must stay valid until the endpoint stops
+    void addCounterFunction(const string& name, const string& help, function<double()> fn);
+    void addGauge(const string& name, const string& help, function<double()> fn);
+
+    // Prometheus text exposition format, version 0.0.4. Entries sharing a
+    // name (label variants) must be registered one after another.
+    string render() const;
+};
+
+// The server's hot-path instruments, all registered with g_metrics
+struct ServerMetrics {
+    Counter& connectionsAccepted;
+    Counter& connectionsRefused;
+    Counter& framesReceived;
+    Counter& bytesReceived;
+    Counter& framesSent;
+    Counter& bytesSent;
+    Counter& rateLimitedByClient;
+    Counter& rateLimitedByRoom;
+    Histogram& broadcastBatch;
+    Histogram& dbCommit;
+
+    ServerMetrics();
+
+    // Latency histogram for a command; CommandId::Unknown is the shared
+    // "other" histogram
+    Histogram& commandLatency(CommandId command) {
+        return *m_commandLatency[static_cast<size_t>(command)];
+    }
+
+private:
+    array<Histogram*, COMMAND_COUNT + 1> m_commandLatency;
+};
+
+extern MetricsRegistry g_metrics;
+extern ServerMetrics g_serverMetrics;
+
+// Registers gauges and counters sampled from server state (connections,
+// queue depths, persistence totals). Call once the broadcasters and the
+// persistence writer exist.
+void registerServerStateMetrics();
\ No newline at end of file
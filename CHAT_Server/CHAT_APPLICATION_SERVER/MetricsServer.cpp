@@ -0,0 +1,219 @@
+#include "MetricsServer.h"
+#include "Metrics.h"
+#include "Utilities.h"
+#include "Logger.h"
+#include <algorithm>
+
+// Requests are a single GET or a one-word PUT; anything longer is not
+// a scraper
+static const size_t MAX_REQUEST_BYTES = 8192;
+
+// Value of the Content-Length header, 0 if there is none
+static size_t parseContentLength(const string& headers) {
+    string lowered = headers;
+    transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c) {
+        return static_cast<char>(tolower(c));
+        });
+
+    size_t pos = lowered.find("\r\ncontent-length:");
+    if (pos == string::npos) {
+        return 0;
+    }
+    return static_cast<size_t>(strtoul(lowered.c_str() + pos + 17, nullptr, 10));
+}
+
+MetricsServer::MetricsServer(int port)
+    : m_port(port)
+    , m_listenSocket(INVALID_SOCKET)
+    , m_stopping(false)
+    , m_scrapes(0) {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start() {
+    m_listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listenSocket == INVALID_SOCKET) {
+        LOG_ERROR("[ERROR] Metrics socket creation failed");
+        return false;
+    }
+
+    setSocketNonBlocking(m_listenSocket);
+
+#ifndef _WIN32
+    int reuseAddr = 1;
+    setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr));
+#endif
+
+    // Loopback only: the endpoint has no authentication
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<u_short>(m_port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(m_listenSocket, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+        listen(m_listenSocket, 16) == SOCKET_ERROR) {
+        LOG_ERROR("[ERROR] Metrics port " << m_port << " unavailable: "
+            << WSAGetLastError());
+        closesocket(m_listenSocket);
+        m_listenSocket = INVALID_SOCKET;
+        return false;
+    }
+
+    m_eventLoop = EventLoop::create();
+    m_eventLoop->addSocket(m_listenSocket);
+    m_thread = thread(&MetricsServer::run, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    m_stopping = true;
+    m_eventLoop->wakeup();
+    m_thread.join();
+
+    closesocket(m_listenSocket);
+    m_listenSocket = INVALID_SOCKET;
+}
+
+void MetricsServer::run() {
+    LOG_INFO("[THREAD] Metrics endpoint listening on 127.0.0.1:" << m_port);
+    vector<IoEvent> events;
+
+    while (!m_stopping) {
+        if (m_eventLoop->wait(events, 1000) == SOCKET_ERROR) {
+            continue;
+        }
+
+        // Edge-triggered on Linux: accept until the backlog is empty
+        while (!m_stopping) {
+            SOCKET clientSocket = accept(m_listenSocket, nullptr, nullptr);
+            if (clientSocket == INVALID_SOCKET) {
+                break;
+            }
+            serveClient(clientSocket);
+            closesocket(clientSocket);
+        }
+    }
+
+    LOG_INFO("[THREAD] Metrics endpoint stopped");
+}
+
+// Reads one request and answers it; the timeouts keep a stalled client
+// from holding up later scrapes for long
+void MetricsServer::serveClient(SOCKET clientSocket) {
+    setSocketBlocking(clientSocket);
+
+#ifdef _WIN32
+    DWORD timeoutMs = 1000;
+    setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeoutMs, sizeof(timeoutMs));
+    setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeoutMs, sizeof(timeoutMs));
+#else
+    timeval timeout = { 1, 0 };
+    setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#endif
+
+    string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == string::npos && request.size() < MAX_REQUEST_BYTES) {
+        int received = recv(clientSocket, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    size_t headerEnd = request.find("\r\n\r\n");
+    if (headerEnd == string::npos) {
+        return;
+    }
+
+    // Request line: METHOD PATH VERSION
+    string method;
+    string path;
+    stringstream requestLine(request.substr(0, request.find("\r\n")));
+    requestLine >> method >> path;
+
+    // Only PUT /log-level carries a body; read the rest of it if needed
+    string requestBody = request.substr(headerEnd + 4);
+    size_t contentLength = parseContentLength(request.substr(0, headerEnd));
+    while (requestBody.size() < contentLength && requestBody.size() < MAX_REQUEST_BYTES) {
+        int received = recv(clientSocket, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            return;
+        }
+        requestBody.append(buffer, static_cast<size_t>(received));
+    }
+
+    string status = "200 OK";
+    string body;
+    if (path == "/metrics" || path == "/") {
+        if (method == "GET") {
+            body = g_metrics.render();
+            m_scrapes++;
+        }
+        else {
+            status = "405 Method Not Allowed";
+            body = "Only GET is supported\n";
+        }
+    }
+    else if (path == "/log-level") {
+        handleLogLevel(method, requestBody, status, body);
+    }
+    else {
+        status = "404 Not Found";
+        body = "Metrics are served at /metrics\n";
+    }
+
+    string response = "HTTP/1.1 " + status + "\r\n"
+        "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+        "Content-Length: " + to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        int result = send(clientSocket, response.data() + sent,
+            static_cast<int>(response.size() - sent), 0);
+        if (result <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(result);
+    }
+}
+
+// GET reports the log level, PUT with "debug", "info", "warn" or "error"
+// as the body changes it
+void MetricsServer::handleLogLevel(const string& method, const string& requestBody,
+    string& status, string& body) {
+    if (method == "PUT") {
+        string text = requestBody.substr(0, requestBody.find_first_of("\r\n"));
+        LogLevel level;
+        if (!parseLogLevel(text, level)) {
+            status = "400 Bad Request";
+            body = "Expected debug, info, warn or error\n";
+            return;
+        }
+
+        LogLevel previous = g_logger.getLevel();
+        g_logger.setLevel(level);
+        LOG_WARN("[ADMIN] Log level changed from " << logLevelName(previous)
+            << " to " << logLevelName(level));
+    }
+    else if (method != "GET") {
+        status = "405 Method Not Allowed";
+        body = "Use GET or PUT\n";
+        return;
+    }
+
+    body = string(logLevelName(g_logger.getLevel())) + "\n";
+}
+
+uint64_t MetricsServer::getScrapes() const {
+    return m_scrapes;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include "Common.h"
+#include "EventLoop.h"
+
+// Admin endpoint on 127.0.0.1 that serves g_metrics to a Prometheus
+// scraper: GET /metrics returns the text exposition format. GET and PUT
+// /log-level read and change the log level of the running server. Runs on
+// its own thread and handles one short-lived request at a time, so a
+// scrape never touches the reactors.
+class MetricsServer {
+private:
+    int m_port;
+    SOCKET m_listenSocket;
+    unique_ptr<EventLoop> m_eventLoop;
+    thread m_thread;
+    atomic<bool> m_stopping;
+    atomic<uint64_t> m_scrapes;
+
+    void run();
+    void serveClient(SOCKET clientSocket);
+    void handleLogLevel(const string& method, const string& requestBody,
+        string& status, string& body);
+
+public:
+    explicit MetricsServer(int port);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Binds the port and starts the thread. Returns false if the port
+    // can't be bound.
+    bool start();
+
+    // Stops the thread; safe to call more than once
+    void stop();
+
+    uint64_t getScrapes() const;
+};
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+#include "Common.h"
+
+// Bounded lock-free multi-producer / single-consumer ring buffer.
+//
+// Every slot carries a sequence number. A producer claims a slot by
+// advancing m_enqueuePos with a CAS, writes the value, then publishes it
+// by bumping the slot's sequence; the consumer only reads slots whose
+// sequence says they are published. Producers never block each other on a
+// mutex and the consumer never takes a lock at all.
+//
+// Capacity must be a power of two. T must be default-constructible and
+// move-assignable.
+template <typename T>
+class MpscQueue {
+private:
+    struct Slot {
+        atomic<size_t> sequence;
+        T value;
+    };
+
+    // Producer and consumer positions live on separate cache lines so the
+    // consumer's stores don't invalidate the line producers CAS on
+    alignas(64) atomic<size_t> m_enqueuePos;
+    alignas(64) atomic<size_t> m_dequeuePos;
+    alignas(64) unique_ptr<Slot[]> m_slots;
+    size_t m_mask;
+
+public:
+    explicit MpscQueue(size_t capacity)
+        : m_enqueuePos(0)
+        , m_dequeuePos(0)
+        , m_slots(new Slot[capacity])
+        , m_mask(capacity - 1) {
+        for (size_t i = 0; i < capacity; i++) {
+            m_slots[i].sequence.store(i, memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread. Returns false without blocking if the ring is full.
+    bool tryPush(T&& value) {
+        size_t pos = m_enqueuePos.load(memory_order_relaxed);
+
+        while (true) {
+            Slot& slot = m_slots[pos & m_mask];
+            size_t sequence = slot.sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    slot.value = move(value);
+                    slot.sequence.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                // The consumer hasn't freed this slot yet: full
+                return false;
+            }
+            else {
+                pos = m_enqueuePos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only.
+    bool tryPop(T& value) {
+        size_t pos = m_dequeuePos.load(memory_order_relaxed);
+        Slot& slot = m_slots[pos & m_mask];
+
+        if (slot.sequence.load(memory_order_acquire) != pos + 1) {
+            return false;
+        }
+
+        value = move(slot.value);
+        slot.value = T();
+        slot.sequence.store(pos + m_mask + 1, memory_order_release);
+        m_dequeuePos.store(pos + 1, memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer thread only. Appends up to maxCount published items to out
+    // and returns how many were taken.
+    size_t popBatch(vector<T>& out, size_t maxCount) {
+        size_t taken = 0;
+        T value;
+        while (taken < maxCount && tryPop(value)) {
+            out.push_back(move(value));
+            taken++;
+        }
+        return taken;
+    }
+
+    // Approximate number of queued items; exact only when quiescent
+    size_t sizeApprox() const {
+        size_t enqueued = m_enqueuePos.load(memory_order_relaxed);
+        size_t dequeued = m_dequeuePos.load(memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    size_t capacity() const {
+        return m_mask + 1;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "PersistenceWriter.h"
+#include "Metrics.h"
+#include "Logger.h"
+
+// Global writer instance
+unique_ptr<PersistenceWriter> g_persistence;
+
+PersistenceWriter::PersistenceWriter(Database& database, size_t batchSize,
+    chrono::milliseconds flushInterval, size_t capacity)
+    : m_database(database)
+    , m_batchSize(batchSize)
+    , m_flushInterval(flushInterval)
+    , m_capacity(capacity)
+    , m_stopping(false)
+    , m_committedMessages(0)
+    , m_failedMessages(0)
+    , m_batches(0)
+    , m_stalls(0)
+    , m_largestBatch(0) {
+}
+
+PersistenceWriter::~PersistenceWriter() {
+    stop();
+}
+
+void PersistenceWriter::start() {
+    m_thread = thread(&PersistenceWriter::run, this);
+}
+
+void PersistenceWriter::stop() {
+    {
+        lock_guard<mutex> lock(m_queueMutex);
+        m_stopping = true;
+    }
+    m_workCV.notify_all();
+    m_spaceCV.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void PersistenceWriter::push(Operation operation) {
+    size_t depth = 0;
+
+    {
+        unique_lock<mutex> lock(m_queueMutex);
+
+        if (m_queue.size() >= m_capacity && !m_stopping) {
+            m_stalls.fetch_add(1, memory_order_relaxed);
+            m_spaceCV.wait(lock, [this] {
+                return m_queue.size() < m_capacity || m_stopping;
+                });
+        }
+
+        m_queue.push_back(move(operation));
+        depth = m_queue.size();
+    }
+
+    // The writer sleeps either until the first row arrives or until a
+    // full batch is ready; nothing in between needs a wakeup
+    if (depth == 1 || depth == m_batchSize) {
+        m_workCV.notify_one();
+    }
+}
+
+void PersistenceWriter::saveMessage(SymbolRef roomId, SymbolRef sender, string content,
+    bool isPrivate, SymbolRef recipient) {
+    push({ Operation::SaveMessage, move(roomId), move(sender), move(content), isPrivate, move(recipient) });
+}
+
+void PersistenceWriter::deleteRoom(SymbolRef roomId) {
+    push({ Operation::DeleteRoom, move(roomId), SymbolRef(), "", false, SymbolRef() });
+}
+
+void PersistenceWriter::run() {
+    LOG_INFO("[THREAD] Persistence writer started");
+    vector<Operation> operations;
+
+    while (true) {
+        {
+            unique_lock<mutex> lock(m_queueMutex);
+            m_workCV.wait(lock, [this] {
+                return !m_queue.empty() || m_stopping;
+                });
+
+            if (m_queue.empty()) {
+                break;
+            }
+
+            // Group-commit window: give later rows a chance to share this
+            // transaction, unless a full batch is already waiting
+            auto deadline = chrono::steady_clock::now() + m_flushInterval;
+            m_workCV.wait_until(lock, deadline, [this] {
+                return m_queue.size() >= m_batchSize || m_stopping;
+                });
+
+            size_t count = min(m_queue.size(), m_batchSize);
+            for (size_t i = 0; i < count; i++) {
+                operations.push_back(move(m_queue.front()));
+                m_queue.pop_front();
+            }
+        }
+        m_spaceCV.notify_all();
+
+        apply(operations);
+        operations.clear();
+    }
+
+    LOG_INFO("[THREAD] Persistence writer stopped");
+}
+
+void PersistenceWriter::apply(vector<Operation>& operations) {
+    vector<MessageRecord> messages;
+    messages.reserve(operations.size());
+
+    for (Operation& operation : operations) {
+        if (operation.kind == Operation::SaveMessage) {
+            messages.push_back({ operation.roomId.str(), operation.sender.str(),
+                move(operation.content), operation.isPrivate, operation.recipient.str() });
+            continue;
+        }
+
+        // Commit what came before so the delete also removes it
+        commitMessages(messages);
+        m_database.deleteRoom(operation.roomId.str());
+    }
+
+    commitMessages(messages);
+}
+
+void PersistenceWriter::commitMessages(vector<MessageRecord>& messages) {
+    if (messages.empty()) {
+        return;
+    }
+
+    auto start = chrono::steady_clock::now();
+    bool committed = m_database.saveMessages(messages);
+    g_serverMetrics.dbCommit.record(chrono::steady_clock::now() - start);
+
+    if (committed) {
+        m_committedMessages.fetch_add(messages.size(), memory_order_relaxed);
+        m_batches.fetch_add(1, memory_order_relaxed);
+
+        size_t largest = m_largestBatch.load(memory_order_relaxed);
+        while (messages.size() > largest &&
+            !m_largestBatch.compare_exchange_weak(largest, messages.size(),
+                memory_order_relaxed)) {
+        }
+    }
+    else {
+        m_failedMessages.fetch_add(messages.size(), memory_order_relaxed);
+        LOG_ERROR("[ERROR] Failed to persist " << messages.size() << " messages");
+    }
+
+    messages.clear();
+}
+
+size_t PersistenceWriter::getDepth() {
+    lock_guard<mutex> lock(m_queueMutex);
+    return m_queue.size();
+}
+
+uint64_t PersistenceWriter::getCommittedMessages() const {
+    return m_committedMessages.load(memory_order_relaxed);
+}
+
+uint64_t PersistenceWriter::getFailedMessages() const {
+    return m_failedMessages.load(memory_order_relaxed);
+}
+
+uint64_t PersistenceWriter::getBatches() const {
+    return m_batches.load(memory_order_relaxed);
+}
+
+uint64_t PersistenceWriter::getStalls() const {
+    return m_stalls.load(memory_order_relaxed);
+}
+
+size_t PersistenceWriter::getLargestBatch() const {
+    return m_largestBatch.load(memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include "Common.h"
+#include "Database.h"
+#include "SymbolTable.h"
+#include <deque>
+
+// Write-behind queue between message delivery and SQLite.
+//
+// Broadcaster threads hand rows to the writer and move on; a single
+// background thread groups them and commits each group in one transaction,
+// so the fsync cost is paid once per batch instead of once per message and
+// database latency never sits on the delivery path.
+//
+// A batch is committed when batchSize rows are waiting or flushInterval has
+// passed since the oldest one arrived, whichever comes first. The queue is
+// bounded: if the database falls that far behind, producers block until
+// the writer catches up rather than letting memory grow without limit.
+//
+// Room deletions go through the same queue so they are applied after every
+// message queued for that room. Names are queued as SymbolRefs, which keeps
+// them interned until they are written, and only turned into text on the
+// writer thread.
+class PersistenceWriter {
+private:
+    struct Operation {
+        enum Kind { SaveMessage, DeleteRoom } kind;
+        SymbolRef roomId;       // The only field used for DeleteRoom
+        SymbolRef sender;
+        string content;
+        bool isPrivate;
+        SymbolRef recipient;
+    };
+
+    Database& m_database;
+    const size_t m_batchSize;
+    const chrono::milliseconds m_flushInterval;
+    const size_t m_capacity;
+
+    deque<Operation> m_queue;
+    mutex m_queueMutex;
+    condition_variable m_workCV;
+    condition_variable m_spaceCV;
+    bool m_stopping;
+    thread m_thread;
+
+    atomic<uint64_t> m_committedMessages;
+    atomic<uint64_t> m_failedMessages;
+    atomic<uint64_t> m_batches;
+    atomic<uint64_t> m_stalls;
+    atomic<size_t> m_largestBatch;
+
+    void push(Operation operation);
+    void run();
+    void apply(vector<Operation>& operations);
+    void commitMessages(vector<MessageRecord>& messages);
+
+public:
+    PersistenceWriter(Database& database, size_t batchSize,
+        chrono::milliseconds flushInterval, size_t capacity);
+    ~PersistenceWriter();
+
+    PersistenceWriter(const PersistenceWriter&) = delete;
+    PersistenceWriter& operator=(const PersistenceWriter&) = delete;
+
+    void start();
+
+    // Commits everything still queued, then joins the writer thread
+    void stop();
+
+    // Any thread. Blocks only while the queue is full.
+    void saveMessage(SymbolRef roomId, SymbolRef sender, string content,
+        bool isPrivate, SymbolRef recipient);
+    void deleteRoom(SymbolRef roomId);
+
+    // Metrics
+    size_t getDepth();
+    uint64_t getCommittedMessages() const;
+    uint64_t getFailedMessages() const;
+    uint64_t getBatches() const;
+    uint64_t getStalls() const;
+    size_t getLargestBatch() const;
+};
+
+// Global writer; null when the database is unavailable
+extern unique_ptr<PersistenceWriter> g_persistence;
\ No newline at end of file
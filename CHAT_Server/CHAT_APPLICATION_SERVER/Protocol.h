@@ -0,0 +1,64 @@
+#pragma once
+
+// ============================================================================
+// WIRE PROTOCOL
+// ============================================================================
+// Every message on the connection is one frame:
+//
+//   +----------------------+-----------+----------+-----------------+
+//   | payload length (u32) | version   | opcode   | payload bytes   |
+//   | big-endian           | (u8)      | (u8)     | (length bytes)  |
+//   +----------------------+-----------+----------+-----------------+
+//
+// This header and Protocol.cpp are shared verbatim by the server and the
+// clients, so they only depend on the standard library.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+constexpr uint8_t PROTOCOL_VERSION = 1;
+constexpr size_t FRAME_HEADER_SIZE = 6;
+constexpr uint32_t MAX_FRAME_PAYLOAD = 64 * 1024;
+
+enum class Opcode : uint8_t {
+    // Client -> Server
+    Chat = 0x01,            // Room message text
+    Command = 0x02,         // Command name and arguments, without the leading '/'
+    PrivateMessage = 0x03,  // "recipient message text", without the leading '@'
+
+    // Server -> Client
+    ServerText = 0x10       // One protocol line (WELCOME:..., ROOM_JOINED:..., chat line)
+};
+
+struct Frame {
+    Opcode opcode;
+    std::string_view payload;   // Points into the decoder; valid until the next feed()
+};
+
+// Appends one encoded frame to out
+void encodeFrame(std::string& out, Opcode opcode, std::string_view payload);
+std::string encodeFrame(Opcode opcode, std::string_view payload);
+
+// Incremental decoder, one per connection. Bytes are fed as they arrive
+// from recv() and complete frames are handed out without copying.
+class FrameDecoder {
+private:
+    std::string m_buffer;
+    size_t m_readOffset;
+    std::string m_error;
+
+public:
+    FrameDecoder();
+
+    // Appends received bytes, discarding frames already handed out
+    void feed(const char* data, size_t length);
+
+    // Extracts the next complete frame. Returns false when more bytes are
+    // needed or the stream is malformed (see hasError).
+    bool next(Frame& frame);
+
+    bool hasError() const;
+    const std::string& getError() const;
+};
\ No newline at end of file
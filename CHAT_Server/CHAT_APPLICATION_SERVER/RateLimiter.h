@@ -0,0 +1,66 @@
+#pragma once
+#include "Common.h"
+#include "Protocol.h"
+#include "TokenBucket.h"
+
+// Flood limit for one sender or one room. A message passes only if both
+// the message-count bucket and the byte bucket can cover it, and then it
+// pays both. A rate of 0 disables that dimension.
+//
+// Each bucket holds RATE_LIMIT_BURST_SECONDS worth of traffic; the byte
+// bucket never holds less than one maximum-size frame, so a large message
+// is delayed by the limit but never refused outright.
+//
+// Not thread-safe, like TokenBucket.
+class RateLimiter {
+private:
+    TokenBucket m_messages;
+    TokenBucket m_bytes;
+    bool m_limitMessages;
+    bool m_limitBytes;
+
+public:
+    RateLimiter(int messagesPerSecond, int bytesPerSecond)
+        : m_messages(messagesPerSecond,
+            max(1.0, static_cast<double>(messagesPerSecond) * RATE_LIMIT_BURST_SECONDS))
+        , m_bytes(bytesPerSecond,
+            max(static_cast<double>(MAX_FRAME_PAYLOAD),
+                static_cast<double>(bytesPerSecond) * RATE_LIMIT_BURST_SECONDS))
+        , m_limitMessages(messagesPerSecond > 0)
+        , m_limitBytes(bytesPerSecond > 0) {
+    }
+
+    bool isEnabled() const {
+        return m_limitMessages || m_limitBytes;
+    }
+
+    // Charges one message of the given size. Returns false, charging
+    // nothing, if either limit would be exceeded.
+    bool admit(size_t bytes, chrono::steady_clock::time_point now = chrono::steady_clock::now()) {
+        double size = static_cast<double>(bytes);
+
+        if ((m_limitMessages && m_messages.available(now) < 1.0) ||
+            (m_limitBytes && m_bytes.available(now) < size)) {
+            return false;
+        }
+
+        if (m_limitMessages) {
+            m_messages.tryTake(1.0, now);
+        }
+        if (m_limitBytes) {
+            m_bytes.tryTake(size, now);
+        }
+        return true;
+    }
+
+    // Returns what admit() charged for a message that was then dropped
+    // by another limit
+    void refund(size_t bytes) {
+        if (m_limitMessages) {
+            m_messages.refund(1.0);
+        }
+        if (m_limitBytes) {
+            m_bytes.refund(static_cast<double>(bytes));
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "Reactor.h"
+#include "Globals.h"
+#include "Utilities.h"
+#include "Server.h"
+#include "ClientInfo.h"
+#include "Protocol.h"
+#include "Config.h"
+#include "Metrics.h"
+#include "Logger.h"
+
+Reactor::Reactor(size_t index, SOCKET listenSocket)
+    : m_index(index)
+    , m_eventLoop(EventLoop::create())
+    , m_listenSocket(listenSocket)
+    , m_connectionCount(0) {
+    if (m_listenSocket != INVALID_SOCKET) {
+        m_eventLoop->addSocket(m_listenSocket);
+
+        // Every reactor admits its share of the configured rate
+        double share = static_cast<double>(g_config.ioThreads);
+        m_admission = make_unique<AdmissionQueue>(m_listenSocket,
+            g_config.acceptRate / share, g_config.acceptBurst / share);
+    }
+}
+
+Reactor::~Reactor() {
+    join();
+}
+
+void Reactor::start() {
+    m_thread = thread(&Reactor::run, this);
+}
+
+void Reactor::join() {
+    if (m_thread.joinable()) {
+        m_eventLoop->wakeup();
+        m_thread.join();
+    }
+}
+
+void Reactor::adopt(SOCKET clientSocket) {
+    // Counted immediately so least-loaded placement sees it
+    m_connectionCount++;
+    {
+        lock_guard<mutex> lock(m_pendingMutex);
+        m_pendingSockets.push_back(clientSocket);
+    }
+    m_eventLoop->wakeup();
+}
+
+size_t Reactor::getConnectionCount() const {
+    return m_connectionCount;
+}
+
+const AdmissionQueue* Reactor::getAdmissionQueue() const {
+    return m_admission.get();
+}
+
+const char* Reactor::getBackendName() const {
+    return m_eventLoop->getBackendName();
+}
+
+// ============================================================================
+// REACTOR THREAD
+// ============================================================================
+
+void Reactor::run() {
+    LOG_INFO("[THREAD] Reactor " << m_index << " started");
+
+    vector<IoEvent> events;
+    vector<SOCKET> flushRequests;
+
+    while (!g_shutdownRequested) {
+        int timeoutMs = m_admission ? m_admission->nextTimeoutMs(100) : 100;
+        int readyCount = m_eventLoop->wait(events, timeoutMs);
+
+        if (readyCount == SOCKET_ERROR) {
+            LOG_ERROR("[ERROR] Reactor " << m_index << " " << m_eventLoop->getBackendName()
+                << " wait failed: " << WSAGetLastError());
+            break;
+        }
+
+        adoptPendingSockets();
+
+        bool listenReady = false;
+        for (const IoEvent& event : events) {
+            if (event.socket == m_listenSocket) {
+                listenReady = true;
+                continue;
+            }
+
+            auto it = m_connections.find(event.socket);
+            if (it == m_connections.end()) {
+                continue;
+            }
+            shared_ptr<Connection> connection = it->second;
+
+            if (event.readable || event.hangup) {
+                if (!readFromClient(*connection)) {
+                    closeConnection(event.socket);
+                    continue;
+                }
+            }
+
+            if (event.writable) {
+                flushClient(event.socket);
+            }
+        }
+
+        if (m_admission) {
+            acceptClients(listenReady);
+        }
+
+        // Deliver output queued by command handlers and the broadcaster
+        m_eventLoop->takeFlushRequests(flushRequests);
+        for (SOCKET clientSocket : flushRequests) {
+            flushClient(clientSocket);
+        }
+    }
+
+    LOG_INFO("[THREAD] Reactor " << m_index << " exiting");
+}
+
+// Drains this reactor's own listening socket and registers the clients
+// the admission queue lets through
+void Reactor::acceptClients(bool listenReady) {
+    if (listenReady || m_admission->needsAccept()) {
+        m_admission->acceptAll();
+    }
+
+    m_admission->admit([this](SOCKET clientSocket) {
+        m_connectionCount++;
+        registerClient(clientSocket);
+        });
+}
+
+void Reactor::adoptPendingSockets() {
+    vector<SOCKET> sockets;
+    {
+        lock_guard<mutex> lock(m_pendingMutex);
+        sockets.swap(m_pendingSockets);
+    }
+
+    for (SOCKET clientSocket : sockets) {
+        registerClient(clientSocket);
+    }
+}
+
+void Reactor::registerClient(SOCKET clientSocket) {
+    LOG_INFO("[CONNECT] New client connected: " << clientSocket
+        << " (reactor " << m_index << ")");
+
+    auto connection = make_shared<Connection>(clientSocket, m_eventLoop.get());
+    m_connections[clientSocket] = connection;
+
+    g_connections.insert(clientSocket, connection);
+
+    g_clients.insert(clientSocket, ClientInfo(clientSocket));
+
+    m_eventLoop->addSocket(clientSocket);
+
+    string welcome = "WELCOME:Chat Server\n";
+    sendToClient(clientSocket, welcome);
+}
+
+// Reads and dispatches frames until the socket would block.
+// Returns false if the client disconnected or sent a malformed stream.
+bool Reactor::readFromClient(Connection& connection) {
+    char buffer[BUFFER_SIZE];
+    SOCKET clientSocket = connection.getSocket();
+    FrameDecoder& decoder = connection.getDecoder();
+
+    // A single recv() may carry several frames or only part of one
+    while (true) {
+        int bytesReceived = recv(clientSocket, buffer, BUFFER_SIZE, 0);
+
+        if (bytesReceived > 0) {
+            decoder.feed(buffer, static_cast<size_t>(bytesReceived));
+            g_serverMetrics.bytesReceived.add(static_cast<uint64_t>(bytesReceived));
+
+            Frame frame;
+            uint64_t frames = 0;
+            while (decoder.next(frame)) {
+                handleClientMessage(clientSocket, frame);
+                frames++;
+            }
+            g_serverMetrics.framesReceived.add(frames);
+
+            if (decoder.hasError()) {
+                LOG_ERROR("[ERROR] Protocol error from client " << clientSocket
+                    << ": " << decoder.getError());
+                return false;
+            }
+            continue;
+        }
+
+        if (bytesReceived < 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
+            return true;
+        }
+        return false;
+    }
+}
+
+// Writes queued output, disconnecting clients whose socket failed or
+// whose outbound queue overflowed
+void Reactor::flushClient(SOCKET clientSocket) {
+    auto it = m_connections.find(clientSocket);
+    if (it == m_connections.end()) {
+        return;
+    }
+
+    if (!it->second->flush()) {
+        // A failed send is almost always the peer hanging up; only a
+        // client too slow to keep up is worth an error
+        if (it->second->hasOverflowed()) {
+            LOG_ERROR("[ERROR] Dropping client " << clientSocket
+                << ": outbound queue full");
+        }
+        else {
+            LOG_INFO("[DISCONNECT] Client " << clientSocket
+                << " closed the connection during send");
+        }
+        closeConnection(clientSocket);
+    }
+}
+
+// Unregisters a client, tears down its state and closes the socket
+void Reactor::closeConnection(SOCKET clientSocket) {
+    auto it = m_connections.find(clientSocket);
+    if (it != m_connections.end()) {
+        it->second->markClosed();
+        m_connections.erase(it);
+    }
+    m_connectionCount--;
+    g_activeConnections--;
+    handleClientDisconnect(clientSocket, *m_eventLoop);
+}
+
+void Reactor::closeAllConnections() {
+    // Sockets handed over after the loop stopped were never registered
+    {
+        lock_guard<mutex> lock(m_pendingMutex);
+        for (SOCKET clientSocket : m_pendingSockets) {
+            closesocket(clientSocket);
+        }
+        m_pendingSockets.clear();
+    }
+
+    for (const auto& pair : m_connections) {
+        closesocket(pair.first);
+    }
+    m_connections.clear();
+    m_connectionCount = 0;
+
+    if (m_admission) {
+        m_admission->closeWaiting();
+    }
+
+    if (m_listenSocket != INVALID_SOCKET) {
+        closesocket(m_listenSocket);
+        m_listenSocket = INVALID_SOCKET;
+    }
+}
\ No newline at end of file
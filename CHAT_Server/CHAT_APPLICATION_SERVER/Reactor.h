@@ -0,0 +1,59 @@
+#pragma once
+#include "Common.h"
+#include "EventLoop.h"
+#include "Connection.h"
+#include "AdmissionQueue.h"
+#include <unordered_map>
+
+// One I/O thread with its own EventLoop. A reactor owns a subset of the
+// client connections: it reads and parses their frames, runs their
+// command handlers and flushes their outbound queues. Connections never
+// move between reactors.
+class Reactor {
+private:
+    size_t m_index;
+    unique_ptr<EventLoop> m_eventLoop;
+    thread m_thread;
+
+    // Own listening socket in reuseport mode, INVALID_SOCKET otherwise,
+    // and the admission queue that accepts from it
+    SOCKET m_listenSocket;
+    unique_ptr<AdmissionQueue> m_admission;
+
+    // Connections owned by this reactor (reactor thread only)
+    unordered_map<SOCKET, shared_ptr<Connection>> m_connections;
+    atomic<size_t> m_connectionCount;
+
+    // Sockets handed over by the acceptor thread
+    vector<SOCKET> m_pendingSockets;
+    mutex m_pendingMutex;
+
+    void run();
+    void acceptClients(bool listenReady);
+    void adoptPendingSockets();
+    void registerClient(SOCKET clientSocket);
+    bool readFromClient(Connection& connection);
+    void flushClient(SOCKET clientSocket);
+    void closeConnection(SOCKET clientSocket);
+
+public:
+    Reactor(size_t index, SOCKET listenSocket);
+    ~Reactor();
+
+    void start();
+
+    // Waits for the thread to leave its loop after shutdown is requested
+    void join();
+
+    // Closes every connection still owned. Only after join().
+    void closeAllConnections();
+
+    // Hands a freshly accepted socket to this reactor. Any thread.
+    void adopt(SOCKET clientSocket);
+
+    size_t getConnectionCount() const;
+
+    // Null unless this reactor accepts for itself (reuseport mode)
+    const AdmissionQueue* getAdmissionQueue() const;
+    const char* getBackendName() const;
+};
\ No newline at end of file
@@ -5,87 +5,86 @@
 #include "ClientInfo.h"
 #include "Message.h"
 #include "Database.h"
+#include "PersistenceWriter.h"
+#include "EventLoop.h"
+#include "Config.h"
+#include "Metrics.h"
+#include "Logger.h"
+#include "CommandTable.h"
+#include <charconv>
 
 // ============================================================================
 // UTILITY FUNCTIONS (Server-Specific)
 // ============================================================================
 
-bool isUsernameAvailable(const string& username, SOCKET excludeSocket) {
-    lock_guard<mutex> lock(g_clientsMutex);
-    for (const auto& pair : g_clients) {
-        if (pair.first != excludeSocket && pair.second.getUsername() == username) {
-            return false;
-        }
-    }
-    return true;
+bool isUsernameAvailable(Symbol username, SOCKET excludeSocket) {
+    SOCKET owner = INVALID_SOCKET;
+    return !g_usernames.get(username, owner) || owner == excludeSocket;
 }
 
-SOCKET findClientByUsername(const string& username, const string& roomId) {
-    lock_guard<mutex> lock(g_clientsMutex);
-    for (const auto& pair : g_clients) {
-        if (pair.second.getUsername() == username &&
-            pair.second.getRoomId() == roomId) {
-            return pair.first;
-        }
+SOCKET findClientByUsername(Symbol username, Symbol roomId) {
+    shared_ptr<ChatRoom> room = findRoom(roomId);
+    return room ? room->findMemberByName(username) : INVALID_SOCKET;
+}
+
+// Drops a username claim if it still belongs to clientSocket
+void releaseUsername(Symbol username, SOCKET clientSocket) {
+    if (username.empty()) {
+        return;
     }
-    return INVALID_SOCKET;
+    g_usernames.eraseIf(username, [clientSocket](SOCKET owner) {
+        return owner == clientSocket;
+        });
+}
+
+shared_ptr<ChatRoom> findRoom(Symbol roomId) {
+    shared_ptr<ChatRoom> room;
+    g_chatRooms.get(roomId, room);
+    return room;
 }
 
 // ============================================================================
 // ROOM MANAGEMENT
 // ============================================================================
 
-void cleanupEmptyRoom(const string& roomId) {
-    lock_guard<mutex> lock(g_chatRoomsMutex);
-    auto it = g_chatRooms.find(roomId);
+void cleanupEmptyRoom(const SymbolRef& roomId) {
+    // Checked and erased under the shard lock, so a concurrent JOIN either
+    // lands before (room not empty) or finds the room gone
+    bool erased = g_chatRooms.eraseIf(roomId, [](const shared_ptr<ChatRoom>& room) {
+        return room->isEmpty();
+        });
 
-    if (it != g_chatRooms.end() && it->second->isEmpty()) {
-        cout << "[CLEANUP] Deleting empty room: " << roomId << endl;
-        g_chatRooms.erase(it);
-        
-        // Delete room from database
-        if (g_database) {
-            g_database->deleteRoom(roomId);
+    if (erased) {
+        LOG_INFO("[CLEANUP] Deleting empty room: " << roomId);
+
+        // Delete room from database, behind any of its queued messages
+        if (g_persistence) {
+            g_persistence->deleteRoom(roomId);
         }
     }
 }
 
 void removeClientFromRoom(SOCKET clientSocket) {
-    string roomId;
-    string username;
-
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        auto clientIt = g_clients.find(clientSocket);
-        if (clientIt == g_clients.end()) {
-            return;
-        }
-
-        roomId = clientIt->second.getRoomId();
-        username = clientIt->second.getUsername();
-
-        if (roomId.empty()) {
-            return;
-        }
+    ClientInfo client;
+    if (!g_clients.get(clientSocket, client) || client.getRoomId().empty()) {
+        return;
     }
 
+    SymbolRef roomId = client.getRoomId();
+
     // Notify others that user left
-    {
-        lock_guard<mutex> roomLock(g_chatRoomsMutex);
-        auto roomIt = g_chatRooms.find(roomId);
-        if (roomIt != g_chatRooms.end()) {
-            string leaveMsg = getCurrentTimestamp() + " SYSTEM: " +
-                username + " has left the room\n";
-            roomIt->second->broadcast(leaveMsg, clientSocket);
-            roomIt->second->removeClient(clientSocket);
-        }
+    shared_ptr<ChatRoom> room = findRoom(roomId);
+    if (room) {
+        string leaveMsg = getCurrentTimestamp() + " SYSTEM: " +
+            client.getUsername().str() + " has left the room\n";
+        room->broadcast(leaveMsg, clientSocket);
+        room->removeClient(clientSocket);
     }
 
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        g_clients[clientSocket].setRoomId("");
-        g_clients[clientSocket].setIsRoomOwner(false);
-    }
+    g_clients.update(clientSocket, [](ClientInfo& info) {
+        info.setRoomId(SymbolRef());
+        info.setIsRoomOwner(false);
+        });
 
     // Cleanup empty room
     cleanupEmptyRoom(roomId);
@@ -95,123 +94,119 @@ void removeClientFromRoom(SOCKET clientSocket) {
 // COMMAND HANDLERS
 // ============================================================================
 
-void handleCreateCommand(SOCKET clientSocket, const string& params) {
-    stringstream ss(params);
-    string typeStr, password;
-    ss >> typeStr;
-
-    bool isPrivate = (typeStr == "PRIVATE");
+void handleCreateCommand(SOCKET clientSocket, string_view params) {
+    CommandTokenizer tokens(params);
+    bool isPrivate = (tokens.next() == "PRIVATE");
+    string password;
 
     if (isPrivate) {
-        getline(ss, password);
-        password = trim(password);
+        password = string(tokens.rest());
         if (password.empty()) {
             sendToClient(clientSocket, "ERROR: Private rooms require a password\n");
             return;
         }
     }
 
-    string roomId = generateRoomId();
-    string ownerUsername;
+    SymbolRef roomId = g_symbols.intern(generateRoomId());
+    if (roomId.empty()) {
+        sendToClient(clientSocket, "ERROR: Cannot create a room right now\n");
+        return;
+    }
+
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
+    SymbolRef ownerUsername = client.getUsername();
 
     // Check if client is already in a room
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        ClientInfo& client = g_clients[clientSocket];
-        ownerUsername = client.getUsername();
-
-        if (!client.getRoomId().empty()) {
-            // Remove from old room first
-            lock_guard<mutex> roomLock(g_chatRoomsMutex);
-            auto oldRoomIt = g_chatRooms.find(client.getRoomId());
-            if (oldRoomIt != g_chatRooms.end()) {
-                string leaveMsg = getCurrentTimestamp() + " SYSTEM: " +
-                    client.getUsername() + " has left the room\n";
-                oldRoomIt->second->broadcast(leaveMsg, clientSocket);
-                oldRoomIt->second->removeClient(clientSocket);
-
-                if (oldRoomIt->second->isEmpty()) {
-                    string oldRoomId = client.getRoomId();
-                    thread([oldRoomId]() {
-                        this_thread::sleep_for(chrono::milliseconds(100));
-                        cleanupEmptyRoom(oldRoomId);
-                        }).detach();
-                }
+    if (!client.getRoomId().empty()) {
+        // Remove from old room first
+        shared_ptr<ChatRoom> oldRoom = findRoom(client.getRoomId());
+        if (oldRoom) {
+            string leaveMsg = getCurrentTimestamp() + " SYSTEM: " +
+                client.getUsername().str() + " has left the room\n";
+            oldRoom->broadcast(leaveMsg, clientSocket);
+            oldRoom->removeClient(clientSocket);
+
+            if (oldRoom->isEmpty()) {
+                SymbolRef oldRoomId = client.getRoomId();
+                thread([oldRoomId]() {
+                    this_thread::sleep_for(chrono::milliseconds(100));
+                    cleanupEmptyRoom(oldRoomId);
+                    }).detach();
             }
         }
     }
 
-    {
-        lock_guard<mutex> roomLock(g_chatRoomsMutex);
-        g_chatRooms[roomId] = make_shared<ChatRoom>(roomId, isPrivate, password, clientSocket);
-        g_chatRooms[roomId]->addClient(clientSocket);
-    }
+    auto room = make_shared<ChatRoom>(roomId, isPrivate, password, clientSocket);
+    room->addClient(clientSocket, ownerUsername, findConnection(clientSocket));
+    g_chatRooms.insert(roomId, room);
 
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        g_clients[clientSocket].setRoomId(roomId);
-        g_clients[clientSocket].setIsRoomOwner(true);
-    }
+    g_clients.update(clientSocket, [&](ClientInfo& info) {
+        info.setRoomId(roomId);
+        info.setIsRoomOwner(true);
+        });
 
     // Save room to database
     if (g_database) {
-        g_database->createRoom(roomId, isPrivate, ownerUsername, password);
+        g_database->createRoom(roomId.str(), isPrivate, ownerUsername.str(), password);
     }
 
-    string response = "ROOM_CREATED:" + roomId + ":" +
+    string response = "ROOM_CREATED:" + roomId.str() + ":" +
         (isPrivate ? "PRIVATE" : "PUBLIC") + "\n";
     sendToClient(clientSocket, response);
 
-    cout << "[CMD] Client " << clientSocket << " created "
-        << (isPrivate ? "private" : "public") << " room: " << roomId << endl;
+    LOG_INFO("[CMD] Client " << clientSocket << " created "
+        << (isPrivate ? "private" : "public") << " room: " << roomId);
 }
 
-void handleJoinCommand(SOCKET clientSocket, const string& params) {
-    stringstream ss(params);
-    string roomId, password;
-    ss >> roomId;
+void handleJoinCommand(SOCKET clientSocket, string_view params) {
+    CommandTokenizer tokens(params);
+    string_view roomText = tokens.next();
 
-    roomId = trim(roomId);
+    if (roomText.empty()) {
+        sendToClient(clientSocket, "ERROR: Room ID cannot be empty\n");
+        return;
+    }
 
+    // An ID that was never interned can't be a room
+    SymbolRef roomId = g_symbols.find(roomText);
     if (roomId.empty()) {
-        sendToClient(clientSocket, "ERROR: Room ID cannot be empty\n");
+        sendToClient(clientSocket, "ROOM_NOT_FOUND\n");
         return;
     }
 
-    lock_guard<mutex> clientLock(g_clientsMutex);
-    ClientInfo& client = g_clients[clientSocket];
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
 
     if (roomId == client.getRoomId()) {
         sendToClient(clientSocket, "ERROR: You are already in this room\n");
         return;
     }
 
-    lock_guard<mutex> roomLock(g_chatRoomsMutex);
-    auto targetRoomIt = g_chatRooms.find(roomId);
+    shared_ptr<ChatRoom> targetRoom = findRoom(roomId);
 
-    if (targetRoomIt == g_chatRooms.end()) {
+    if (!targetRoom) {
         sendToClient(clientSocket, "ROOM_NOT_FOUND\n");
         return;
     }
 
     // Check if user is banned (check both in-memory and database)
-    if (targetRoomIt->second->isUserBanned(client.getUsername()) ||
-        (g_database && g_database->isUserBanned(roomId, client.getUsername()))) {
+    if (targetRoom->isUserBanned(client.getUsername()) ||
+        (g_database && g_database->isUserBanned(roomId.str(), client.getUsername().str()))) {
         sendToClient(clientSocket, "ERROR: You are banned from this room\n");
         return;
     }
 
     // Check if room is private
-    if (targetRoomIt->second->getIsPrivate()) {
-        getline(ss, password);
-        password = trim(password);
+    if (targetRoom->getIsPrivate()) {
+        string password(tokens.rest());
 
         if (password.empty()) {
             sendToClient(clientSocket, "PASSWORD_REQUIRED\n");
             return;
         }
 
-        if (!targetRoomIt->second->verifyPassword(password)) {
+        if (!targetRoom->verifyPassword(password)) {
             sendToClient(clientSocket, "WRONG_PASSWORD\n");
             return;
         }
@@ -219,15 +214,15 @@ void handleJoinCommand(SOCKET clientSocket, const string& params) {
 
     // Remove from old room
     if (!client.getRoomId().empty()) {
-        auto oldRoomIt = g_chatRooms.find(client.getRoomId());
-        if (oldRoomIt != g_chatRooms.end()) {
+        shared_ptr<ChatRoom> oldRoom = findRoom(client.getRoomId());
+        if (oldRoom) {
             string leaveMsg = getCurrentTimestamp() + " SYSTEM: " +
-                client.getUsername() + " has left the room\n";
-            oldRoomIt->second->broadcast(leaveMsg, clientSocket);
-            oldRoomIt->second->removeClient(clientSocket);
+                client.getUsername().str() + " has left the room\n";
+            oldRoom->broadcast(leaveMsg, clientSocket);
+            oldRoom->removeClient(clientSocket);
 
-            if (oldRoomIt->second->isEmpty()) {
-                string oldRoomId = client.getRoomId();
+            if (oldRoom->isEmpty()) {
+                SymbolRef oldRoomId = client.getRoomId();
                 thread([oldRoomId]() {
                     this_thread::sleep_for(chrono::milliseconds(100));
                     cleanupEmptyRoom(oldRoomId);
@@ -236,107 +231,144 @@ void handleJoinCommand(SOCKET clientSocket, const string& params) {
         }
     }
 
-    // Join new room
-    targetRoomIt->second->addClient(clientSocket);
-    client.setRoomId(roomId);
-    client.setIsRoomOwner(false);
+    // Join new room. Done under the registry's shared lock so an empty-room
+    // cleanup cannot delete the room between the lookup and the join.
+    shared_ptr<Connection> connection = findConnection(clientSocket);
+    bool joined = g_chatRooms.read(roomId, [&](const shared_ptr<ChatRoom>& room) {
+        room->addClient(clientSocket, client.getUsername(), connection);
+        targetRoom = room;
+        });
 
-    string response = "ROOM_JOINED:" + roomId + "\n";
-    sendToClient(clientSocket, response);
+    g_clients.update(clientSocket, [&](ClientInfo& info) {
+        info.setRoomId(joined ? roomId : SymbolRef());
+        info.setIsRoomOwner(false);
+        });
 
-    // Send message history - first from database, then from memory
-    vector<string> history;
-    if (g_database) {
-        history = g_database->getMessageHistory(roomId, MAX_MESSAGE_HISTORY);
+    if (!joined) {
+        sendToClient(clientSocket, "ROOM_NOT_FOUND\n");
+        return;
     }
-    
-    // If database history is empty, use in-memory history
-    if (history.empty()) {
-        history = targetRoomIt->second->getMessageHistory();
+
+    // Send message history from the room's ring of encoded frames. The
+    // database is only read once, for a room that has never had history
+    // in memory; the ring holds the latest messages even while the
+    // persistence writer is still catching up.
+    if (targetRoom->needsHistoryHydration() && g_database) {
+        vector<SharedPayload> stored;
+        for (const string& msg : g_database->getMessageHistory(roomId.str(), MAX_MESSAGE_HISTORY)) {
+            stored.push_back(makeServerTextPayload(msg));
+        }
+        targetRoom->hydrateHistory(stored);
     }
 
+    // The confirmation and the whole replay are queued in one call, so the
+    // I/O thread can write them with a single gather send
+    static const SharedPayload s_historyStart = makeServerTextPayload("MESSAGE_HISTORY_START\n");
+    static const SharedPayload s_historyEnd = makeServerTextPayload("MESSAGE_HISTORY_END\n");
+
+    vector<SharedPayload> history = targetRoom->getMessageHistory();
+    vector<SharedPayload> reply;
+    reply.reserve(history.size() + 3);
+    reply.push_back(makeServerTextPayload("ROOM_JOINED:" + roomId.str() + "\n"));
+
     if (!history.empty()) {
-        sendToClient(clientSocket, "MESSAGE_HISTORY_START\n");
-        for (const string& msg : history) {
-            sendToClient(clientSocket, msg);
-        }
-        sendToClient(clientSocket, "MESSAGE_HISTORY_END\n");
+        reply.push_back(s_historyStart);
+        reply.insert(reply.end(), history.begin(), history.end());
+        reply.push_back(s_historyEnd);
     }
+    sendToClient(clientSocket, reply);
 
     // Notify others
     string joinMsg = getCurrentTimestamp() + " SYSTEM: " +
-        client.getUsername() + " has joined the room\n";
-    targetRoomIt->second->broadcast(joinMsg, clientSocket);
+        client.getUsername().str() + " has joined the room\n";
+    targetRoom->broadcast(joinMsg, clientSocket);
 
-    cout << "[CMD] Client " << clientSocket << " (" << client.getUsername()
-        << ") joined room: " << roomId << endl;
+    LOG_INFO("[CMD] Client " << clientSocket << " (" << client.getUsername()
+        << ") joined room: " << roomId);
 }
 
-void handleSetNameCommand(SOCKET clientSocket, const string& name) {
-    string trimmedName = trim(name);
+void handleSetNameCommand(SOCKET clientSocket, string_view name) {
+    string trimmedName(trimView(name));
 
     if (trimmedName.empty()) {
         sendToClient(clientSocket, "ERROR: Name cannot be empty\n");
         return;
     }
 
-    if (!isUsernameAvailable(trimmedName, clientSocket)) {
+    SymbolRef newName = g_symbols.intern(trimmedName);
+    if (newName.empty()) {
+        sendToClient(clientSocket, "ERROR: Cannot set a new name right now\n");
+        return;
+    }
+
+    // Claim the name first; only one of several concurrent SETNAMEs wins
+    if (!g_usernames.tryInsert(newName, clientSocket) &&
+        !isUsernameAvailable(newName, clientSocket)) {
         sendToClient(clientSocket, "NAME_TAKEN\n");
         return;
     }
 
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        g_clients[clientSocket].setUsername(trimmedName);
+    // oldName keeps the old name interned until its claim is dropped
+    SymbolRef oldName;
+    SymbolRef roomId;
+    bool connected = g_clients.update(clientSocket, [&](ClientInfo& client) {
+        oldName = client.getUsername();
+        roomId = client.getRoomId();
+        client.setUsername(newName);
+        });
+
+    if (!connected) {
+        releaseUsername(newName, clientSocket);
+        return;
+    }
+
+    if (oldName != newName) {
+        releaseUsername(oldName, clientSocket);
+
+        // Keep the room's member index in step with the new name
+        if (!roomId.empty()) {
+            shared_ptr<ChatRoom> room = findRoom(roomId);
+            if (room) {
+                room->renameClient(clientSocket, newName);
+            }
+        }
     }
 
     sendToClient(clientSocket, "NAME_SET\n");
-    cout << "[CMD] Client " << clientSocket << " set name: " << trimmedName << endl;
+    LOG_INFO("[CMD] Client " << clientSocket << " set name: " << trimmedName);
 }
 
 void handleListCommand(SOCKET clientSocket) {
-    lock_guard<mutex> roomLock(g_chatRoomsMutex);
-
     string response = "ROOMS_LIST:";
-    for (const auto& pair : g_chatRooms) {
-        response += pair.first + "(" + to_string(pair.second->getClientCount()) + ")" +
-            (pair.second->getIsPrivate() ? "[PRIVATE]" : "[PUBLIC]") + ",";
-    }
+    g_chatRooms.forEach([&](Symbol roomId, const shared_ptr<ChatRoom>& room) {
+        response += roomId.str() + "(" + to_string(room->getClientCount()) + ")" +
+            (room->getIsPrivate() ? "[PRIVATE]" : "[PUBLIC]") + ",";
+        });
     response += "\n";
 
     sendToClient(clientSocket, response);
-    cout << "[CMD] Client " << clientSocket << " requested room list" << endl;
+    LOG_DEBUG("[CMD] Client " << clientSocket << " requested room list");
 }
 
 void handleGetPasswordCommand(SOCKET clientSocket) {
-    string roomId;
-    bool isOwner = false;
-
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        auto it = g_clients.find(clientSocket);
-        if (it != g_clients.end()) {
-            roomId = it->second.getRoomId();
-            isOwner = it->second.isRoomOwner();
-        }
-    }
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
 
-    if (roomId.empty()) {
+    if (client.getRoomId().empty()) {
         sendToClient(clientSocket, "ERROR: You are not in a room\n");
         return;
     }
 
-    if (!isOwner) {
+    if (!client.isRoomOwner()) {
         sendToClient(clientSocket, "ERROR: Only room owner can view password\n");
         return;
     }
 
-    lock_guard<mutex> roomLock(g_chatRoomsMutex);
-    auto roomIt = g_chatRooms.find(roomId);
+    shared_ptr<ChatRoom> room = findRoom(client.getRoomId());
 
-    if (roomIt != g_chatRooms.end()) {
-        if (roomIt->second->getIsPrivate()) {
-            string response = "ROOM_PASSWORD:" + roomIt->second->getPassword() + "\n";
+    if (room) {
+        if (room->getIsPrivate()) {
+            string response = "ROOM_PASSWORD:" + room->getPassword() + "\n";
             sendToClient(clientSocket, response);
         }
         else {
@@ -346,80 +378,57 @@ void handleGetPasswordCommand(SOCKET clientSocket) {
 }
 
 void handleUsersCommand(SOCKET clientSocket) {
-    string roomId;
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
 
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        auto it = g_clients.find(clientSocket);
-        if (it != g_clients.end()) {
-            roomId = it->second.getRoomId();
-        }
-    }
-
-    if (roomId.empty()) {
+    if (client.getRoomId().empty()) {
         sendToClient(clientSocket, "ERROR: You are not in a room\n");
         return;
     }
 
-    lock_guard<mutex> roomLock(g_chatRoomsMutex);
-    auto roomIt = g_chatRooms.find(roomId);
-
-    if (roomIt != g_chatRooms.end()) {
-        set<SOCKET> roomClients = roomIt->second->getClients();
+    shared_ptr<ChatRoom> room = findRoom(client.getRoomId());
 
+    if (room) {
         string response = "USERS_LIST:";
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        for (SOCKET sock : roomClients) {
-            auto clientIt = g_clients.find(sock);
-            if (clientIt != g_clients.end() && !clientIt->second.getUsername().empty()) {
-                response += clientIt->second.getUsername() + ",";
-            }
+        for (const SymbolRef& memberName : room->getMemberNames()) {
+            response += memberName.str() + ",";
         }
         response += "\n";
 
         sendToClient(clientSocket, response);
-        cout << "[CMD] Client " << clientSocket << " requested users list" << endl;
+        LOG_DEBUG("[CMD] Client " << clientSocket << " requested users list");
     }
 }
 
-void handleKickCommand(SOCKET clientSocket, const string& params) {
-    string targetUsername = trim(params);
+void handleKickCommand(SOCKET clientSocket, string_view params) {
+    string targetUsername(trimView(params));
 
     if (targetUsername.empty()) {
         sendToClient(clientSocket, "ERROR: Please specify a username to kick\n");
         return;
     }
 
-    string roomId;
-    bool isOwner = false;
-    string ownerName;
-
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        auto it = g_clients.find(clientSocket);
-        if (it != g_clients.end()) {
-            roomId = it->second.getRoomId();
-            isOwner = it->second.isRoomOwner();
-            ownerName = it->second.getUsername();
-        }
-    }
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
+    SymbolRef roomId = client.getRoomId();
 
     if (roomId.empty()) {
         sendToClient(clientSocket, "ERROR: You are not in a room\n");
         return;
     }
 
-    if (!isOwner) {
+    if (!client.isRoomOwner()) {
         sendToClient(clientSocket, "ERROR: Only room owner can kick users\n");
         return;
     }
 
-    if (targetUsername == ownerName) {
+    SymbolRef target = g_symbols.find(targetUsername);
+    if (!target.empty() && target == client.getUsername()) {
         sendToClient(clientSocket, "ERROR: You cannot kick yourself\n");
         return;
     }
 
-    SOCKET targetSocket = findClientByUsername(targetUsername, roomId);
+    SOCKET targetSocket = findClientByUsername(target, roomId);
 
     if (targetSocket == INVALID_SOCKET) {
         sendToClient(clientSocket, "ERROR: User not found in this room\n");
@@ -432,139 +441,121 @@ void handleKickCommand(SOCKET clientSocket, const string& params) {
     sendToClient(targetSocket, "KICKED_FROM_ROOM\n");
 
     // Remove from room
-    {
-        lock_guard<mutex> roomLock(g_chatRoomsMutex);
-        auto roomIt = g_chatRooms.find(roomId);
-        if (roomIt != g_chatRooms.end()) {
-            string kickMsg = getCurrentTimestamp() + " SYSTEM: " +
-                targetUsername + " has been kicked from the room\n";
-            roomIt->second->broadcastToAll(kickMsg);
-            roomIt->second->removeClient(targetSocket);
-        }
+    shared_ptr<ChatRoom> room = findRoom(roomId);
+    if (room) {
+        string kickMsg = getCurrentTimestamp() + " SYSTEM: " +
+            targetUsername + " has been kicked from the room\n";
+        room->broadcastToAll(kickMsg);
+        room->removeClient(targetSocket);
     }
 
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        g_clients[targetSocket].setRoomId("");
-        g_clients[targetSocket].setIsRoomOwner(false);
-    }
+    g_clients.update(targetSocket, [](ClientInfo& target) {
+        target.setRoomId(SymbolRef());
+        target.setIsRoomOwner(false);
+        });
 
-    cout << "[CMD] Client " << clientSocket << " kicked " << targetUsername
-        << " from room " << roomId << endl;
+    LOG_INFO("[CMD] Client " << clientSocket << " kicked " << targetUsername
+        << " from room " << roomId);
 }
 
-void handleBanCommand(SOCKET clientSocket, const string& params) {
-    string targetUsername = trim(params);
+void handleBanCommand(SOCKET clientSocket, string_view params) {
+    string targetUsername(trimView(params));
 
     if (targetUsername.empty()) {
         sendToClient(clientSocket, "ERROR: Please specify a username to ban\n");
         return;
     }
 
-    string roomId;
-    bool isOwner = false;
-    string ownerName;
-
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        auto it = g_clients.find(clientSocket);
-        if (it != g_clients.end()) {
-            roomId = it->second.getRoomId();
-            isOwner = it->second.isRoomOwner();
-            ownerName = it->second.getUsername();
-        }
-    }
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
+    SymbolRef roomId = client.getRoomId();
 
     if (roomId.empty()) {
         sendToClient(clientSocket, "ERROR: You are not in a room\n");
         return;
     }
 
-    if (!isOwner) {
+    if (!client.isRoomOwner()) {
         sendToClient(clientSocket, "ERROR: Only room owner can ban users\n");
         return;
     }
 
-    if (targetUsername == ownerName) {
+    // Looked up, not interned, so banning made-up names can't grow the
+    // symbol table. A name nobody holds can't be in the room; its ban
+    // lives in the database, which JOIN checks as well.
+    SymbolRef target = g_symbols.find(targetUsername);
+    if (!target.empty() && target == client.getUsername()) {
         sendToClient(clientSocket, "ERROR: You cannot ban yourself\n");
         return;
     }
 
-    SOCKET targetSocket = findClientByUsername(targetUsername, roomId);
-
-    {
-        lock_guard<mutex> roomLock(g_chatRoomsMutex);
-        auto roomIt = g_chatRooms.find(roomId);
-        if (roomIt != g_chatRooms.end()) {
-            roomIt->second->banUser(targetUsername);
+    SOCKET targetSocket = findClientByUsername(target, roomId);
 
-            // Save ban to database
-            if (g_database) {
-                g_database->addBan(roomId, targetUsername);
-            }
+    shared_ptr<ChatRoom> room = findRoom(roomId);
+    if (room) {
+        if (!target.empty()) {
+            room->banUser(target);
+        }
 
-            if (targetSocket != INVALID_SOCKET) {
-                // User is currently in the room, kick them
-                sendToClient(targetSocket, getCurrentTimestamp() +
-                    " SYSTEM: You have been banned from the room by the owner\n");
-                sendToClient(targetSocket, "KICKED_FROM_ROOM\n");
+        // Save ban to database
+        if (g_database) {
+            g_database->addBan(roomId.str(), targetUsername);
+        }
 
-                string banMsg = getCurrentTimestamp() + " SYSTEM: " +
-                    targetUsername + " has been banned from the room\n";
-                roomIt->second->broadcastToAll(banMsg);
-                roomIt->second->removeClient(targetSocket);
+        if (targetSocket != INVALID_SOCKET) {
+            // User is currently in the room, kick them
+            sendToClient(targetSocket, getCurrentTimestamp() +
+                " SYSTEM: You have been banned from the room by the owner\n");
+            sendToClient(targetSocket, "KICKED_FROM_ROOM\n");
 
-                lock_guard<mutex> clientLock(g_clientsMutex);
-                g_clients[targetSocket].setRoomId("");
-                g_clients[targetSocket].setIsRoomOwner(false);
-            }
+            string banMsg = getCurrentTimestamp() + " SYSTEM: " +
+                targetUsername + " has been banned from the room\n";
+            room->broadcastToAll(banMsg);
+            room->removeClient(targetSocket);
 
-            sendToClient(clientSocket, "SUCCESS: User " + targetUsername + " has been banned\n");
+            g_clients.update(targetSocket, [](ClientInfo& target) {
+                target.setRoomId(SymbolRef());
+                target.setIsRoomOwner(false);
+                });
         }
+
+        sendToClient(clientSocket, "SUCCESS: User " + targetUsername + " has been banned\n");
     }
 
-    cout << "[CMD] Client " << clientSocket << " banned " << targetUsername
-        << " from room " << roomId << endl;
+    LOG_INFO("[CMD] Client " << clientSocket << " banned " << targetUsername
+        << " from room " << roomId);
 }
 
-void handleTransferCommand(SOCKET clientSocket, const string& params) {
-    string targetUsername = trim(params);
+void handleTransferCommand(SOCKET clientSocket, string_view params) {
+    string targetUsername(trimView(params));
 
     if (targetUsername.empty()) {
         sendToClient(clientSocket, "ERROR: Please specify a username to transfer ownership\n");
         return;
     }
 
-    string roomId;
-    bool isOwner = false;
-    string ownerName;
-
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        auto it = g_clients.find(clientSocket);
-        if (it != g_clients.end()) {
-            roomId = it->second.getRoomId();
-            isOwner = it->second.isRoomOwner();
-            ownerName = it->second.getUsername();
-        }
-    }
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
+    SymbolRef roomId = client.getRoomId();
+    SymbolRef ownerName = client.getUsername();
 
     if (roomId.empty()) {
         sendToClient(clientSocket, "ERROR: You are not in a room\n");
         return;
     }
 
-    if (!isOwner) {
+    if (!client.isRoomOwner()) {
         sendToClient(clientSocket, "ERROR: Only room owner can transfer ownership\n");
         return;
     }
 
-    if (targetUsername == ownerName) {
+    SymbolRef target = g_symbols.find(targetUsername);
+    if (!target.empty() && target == ownerName) {
         sendToClient(clientSocket, "ERROR: You are already the owner\n");
         return;
     }
 
-    SOCKET targetSocket = findClientByUsername(targetUsername, roomId);
+    SOCKET targetSocket = findClientByUsername(target, roomId);
 
     if (targetSocket == INVALID_SOCKET) {
         sendToClient(clientSocket, "ERROR: User not found in this room\n");
@@ -572,459 +563,511 @@ void handleTransferCommand(SOCKET clientSocket, const string& params) {
     }
 
     // Transfer ownership
-    {
-        lock_guard<mutex> roomLock(g_chatRoomsMutex);
-        auto roomIt = g_chatRooms.find(roomId);
-        if (roomIt != g_chatRooms.end()) {
-            roomIt->second->setOwner(targetSocket);
-
-            lock_guard<mutex> clientLock(g_clientsMutex);
-            g_clients[clientSocket].setIsRoomOwner(false);
-            g_clients[targetSocket].setIsRoomOwner(true);
-
-            // Update owner in database
-            if (g_database) {
-                g_database->updateRoomOwner(roomId, targetUsername);
-            }
+    shared_ptr<ChatRoom> room = findRoom(roomId);
+    if (room) {
+        room->setOwner(targetSocket);
+
+        g_clients.update(clientSocket, [](ClientInfo& owner) {
+            owner.setIsRoomOwner(false);
+            });
+        g_clients.update(targetSocket, [](ClientInfo& target) {
+            target.setIsRoomOwner(true);
+            });
+
+        // Update owner in database
+        if (g_database) {
+            g_database->updateRoomOwner(roomId.str(), targetUsername);
+        }
 
-            string transferMsg = getCurrentTimestamp() +
-                " SYSTEM: Room ownership transferred to " +
-                targetUsername + "\n";
-            roomIt->second->broadcastToAll(transferMsg);
+        string transferMsg = getCurrentTimestamp() +
+            " SYSTEM: Room ownership transferred to " +
+            targetUsername + "\n";
+        room->broadcastToAll(transferMsg);
 
-            sendToClient(clientSocket, "SUCCESS: Ownership transferred to " +
-                targetUsername + "\n");
-            sendToClient(targetSocket, "OWNERSHIP_RECEIVED\n");
-        }
+        sendToClient(clientSocket, "SUCCESS: Ownership transferred to " +
+            targetUsername + "\n");
+        sendToClient(targetSocket, "OWNERSHIP_RECEIVED\n");
     }
 
-    cout << "[CMD] Ownership of room " << roomId << " transferred from "
-        << ownerName << " to " << targetUsername << endl;
+    LOG_INFO("[CMD] Ownership of room " << roomId << " transferred from "
+        << ownerName << " to " << targetUsername);
 }
 
 void handleLeaveCommand(SOCKET clientSocket) {
-    string roomId;
-    bool isOwner = false;
-    string username;
-
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        auto it = g_clients.find(clientSocket);
-        if (it != g_clients.end()) {
-            roomId = it->second.getRoomId();
-            isOwner = it->second.isRoomOwner();
-            username = it->second.getUsername();
-        }
-    }
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
+    SymbolRef roomId = client.getRoomId();
+    SymbolRef username = client.getUsername();
 
     if (roomId.empty()) {
         sendToClient(clientSocket, "ERROR: You are not in a room\n");
         return;
     }
 
-    if (isOwner) {
+    if (client.isRoomOwner()) {
         sendToClient(clientSocket, "OWNER_LEAVE_WARNING\n");
         return;
     }
 
     // Leave room
-    {
-        lock_guard<mutex> roomLock(g_chatRoomsMutex);
-        auto roomIt = g_chatRooms.find(roomId);
-        if (roomIt != g_chatRooms.end()) {
-            string leaveMsg = getCurrentTimestamp() + " SYSTEM: " +
-                username + " has left the room\n";
-            roomIt->second->broadcast(leaveMsg, clientSocket);
-            roomIt->second->removeClient(clientSocket);
-
-            if (roomIt->second->isEmpty()) {
-                thread([roomId]() {
-                    this_thread::sleep_for(chrono::milliseconds(100));
-                    cleanupEmptyRoom(roomId);
-                    }).detach();
-            }
+    shared_ptr<ChatRoom> room = findRoom(roomId);
+    if (room) {
+        string leaveMsg = getCurrentTimestamp() + " SYSTEM: " +
+            username.str() + " has left the room\n";
+        room->broadcast(leaveMsg, clientSocket);
+        room->removeClient(clientSocket);
+
+        if (room->isEmpty()) {
+            thread([roomId]() {
+                this_thread::sleep_for(chrono::milliseconds(100));
+                cleanupEmptyRoom(roomId);
+                }).detach();
         }
     }
 
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        g_clients[clientSocket].setRoomId("");
-    }
+    g_clients.update(clientSocket, [](ClientInfo& info) {
+        info.setRoomId(SymbolRef());
+        });
 
     sendToClient(clientSocket, "LEFT_ROOM\n");
-    cout << "[CMD] Client " << clientSocket << " (" << username
-        << ") left room: " << roomId << endl;
+    LOG_INFO("[CMD] Client " << clientSocket << " (" << username
+        << ") left room: " << roomId);
 }
 
 void handleForceLeaveCommand(SOCKET clientSocket) {
-    string roomId;
-    bool isOwner = false;
-    string username;
-
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        auto it = g_clients.find(clientSocket);
-        if (it != g_clients.end()) {
-            roomId = it->second.getRoomId();
-            isOwner = it->second.isRoomOwner();
-            username = it->second.getUsername();
-        }
-    }
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
+    SymbolRef roomId = client.getRoomId();
+    SymbolRef username = client.getUsername();
 
     if (roomId.empty()) {
         sendToClient(clientSocket, "ERROR: You are not in a room\n");
         return;
     }
 
-    if (!isOwner) {
+    if (!client.isRoomOwner()) {
         sendToClient(clientSocket, "ERROR: This command is for room owners\n");
         return;
     }
 
     // Owner forcing leave - transfer to longest member
     SOCKET newOwner = INVALID_SOCKET;
-    string newOwnerName;
-
-    {
-        lock_guard<mutex> roomLock(g_chatRoomsMutex);
-        auto roomIt = g_chatRooms.find(roomId);
-        if (roomIt != g_chatRooms.end()) {
-            if (roomIt->second->getClientCount() > 1) {
-                newOwner = roomIt->second->getLongestMember();
-
-                // If the longest member is the current owner, find the next one
-                if (newOwner == clientSocket) {
-                    set<SOCKET> roomClients = roomIt->second->getClients();
-                    for (SOCKET sock : roomClients) {
-                        if (sock != clientSocket) {
-                            newOwner = sock;
-                            break;
-                        }
-                    }
-                }
-
-                if (newOwner != INVALID_SOCKET && newOwner != clientSocket) {
-                    lock_guard<mutex> clientLock(g_clientsMutex);
-                    auto newOwnerIt = g_clients.find(newOwner);
-                    if (newOwnerIt != g_clients.end()) {
-                        newOwnerName = newOwnerIt->second.getUsername();
-                        g_clients[newOwner].setIsRoomOwner(true);
-                        roomIt->second->setOwner(newOwner);
-                    }
+    SymbolRef newOwnerName;
+
+    shared_ptr<ChatRoom> room = findRoom(roomId);
+    if (room) {
+        if (room->getClientCount() > 1) {
+            newOwner = room->getLongestMember(clientSocket);
+
+            if (newOwner != INVALID_SOCKET) {
+                bool promoted = g_clients.update(newOwner, [&](ClientInfo& member) {
+                    newOwnerName = member.getUsername();
+                    member.setIsRoomOwner(true);
+                    });
+                if (promoted) {
+                    room->setOwner(newOwner);
                 }
             }
+        }
 
-            string leaveMsg = getCurrentTimestamp() + " SYSTEM: " +
-                username + " has left the room\n";
-            if (!newOwnerName.empty()) {
-                string transferMsg = getCurrentTimestamp() +
-                    " SYSTEM: Room ownership transferred to " +
-                    newOwnerName + "\n";
-                roomIt->second->broadcastToAll(transferMsg);
-                sendToClient(newOwner, "OWNERSHIP_RECEIVED\n");
-            }
-            roomIt->second->broadcast(leaveMsg, clientSocket);
-            roomIt->second->removeClient(clientSocket);
-
-            if (roomIt->second->isEmpty()) {
-                thread([roomId]() {
-                    this_thread::sleep_for(chrono::milliseconds(100));
-                    cleanupEmptyRoom(roomId);
-                    }).detach();
-            }
+        string leaveMsg = getCurrentTimestamp() + " SYSTEM: " +
+            username.str() + " has left the room\n";
+        if (!newOwnerName.empty()) {
+            string transferMsg = getCurrentTimestamp() +
+                " SYSTEM: Room ownership transferred to " +
+                newOwnerName.str() + "\n";
+            room->broadcastToAll(transferMsg);
+            sendToClient(newOwner, "OWNERSHIP_RECEIVED\n");
+        }
+        room->broadcast(leaveMsg, clientSocket);
+        room->removeClient(clientSocket);
+
+        if (room->isEmpty()) {
+            thread([roomId]() {
+                this_thread::sleep_for(chrono::milliseconds(100));
+                cleanupEmptyRoom(roomId);
+                }).detach();
         }
     }
 
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        g_clients[clientSocket].setRoomId("");
-        g_clients[clientSocket].setIsRoomOwner(false);
-    }
+    g_clients.update(clientSocket, [](ClientInfo& info) {
+        info.setRoomId(SymbolRef());
+        info.setIsRoomOwner(false);
+        });
 
     sendToClient(clientSocket, "LEFT_ROOM\n");
-    cout << "[CMD] Owner " << clientSocket << " (" << username
-        << ") force left room: " << roomId << endl;
+    LOG_INFO("[CMD] Owner " << clientSocket << " (" << username
+        << ") force left room: " << roomId);
 }
 
-void handleChangePasswordCommand(SOCKET clientSocket, const string& params) {
-    string newPassword = trim(params);
+void handleChangePasswordCommand(SOCKET clientSocket, string_view params) {
+    string newPassword(trimView(params));
 
     if (newPassword.empty()) {
         sendToClient(clientSocket, "ERROR: Password cannot be empty\n");
         return;
     }
 
-    string roomId;
-    bool isOwner = false;
-
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        auto it = g_clients.find(clientSocket);
-        if (it != g_clients.end()) {
-            roomId = it->second.getRoomId();
-            isOwner = it->second.isRoomOwner();
-        }
-    }
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
+    SymbolRef roomId = client.getRoomId();
 
     if (roomId.empty()) {
         sendToClient(clientSocket, "ERROR: You are not in a room\n");
         return;
     }
 
-    if (!isOwner) {
+    if (!client.isRoomOwner()) {
         sendToClient(clientSocket, "ERROR: Only room owner can change password\n");
         return;
     }
 
-    {
-        lock_guard<mutex> roomLock(g_chatRoomsMutex);
-        auto roomIt = g_chatRooms.find(roomId);
-        if (roomIt != g_chatRooms.end()) {
-            if (!roomIt->second->getIsPrivate()) {
-                sendToClient(clientSocket, "ERROR: This is a public room\n");
-                return;
-            }
+    shared_ptr<ChatRoom> room = findRoom(roomId);
+    if (room) {
+        if (!room->getIsPrivate()) {
+            sendToClient(clientSocket, "ERROR: This is a public room\n");
+            return;
+        }
 
-            roomIt->second->setPassword(newPassword);
+        room->setPassword(newPassword);
 
-            // Update password in database
-            if (g_database) {
-                g_database->updateRoomPassword(roomId, newPassword);
-            }
+        // Update password in database
+        if (g_database) {
+            g_database->updateRoomPassword(roomId.str(), newPassword);
+        }
 
-            sendToClient(clientSocket, "PASSWORD_CHANGED:" + newPassword + "\n");
+        sendToClient(clientSocket, "PASSWORD_CHANGED:" + newPassword + "\n");
 
-            string sysMsg = getCurrentTimestamp() +
-                " SYSTEM: Room password has been changed by the owner\n";
-            roomIt->second->broadcast(sysMsg, clientSocket);
-        }
+        string sysMsg = getCurrentTimestamp() +
+            " SYSTEM: Room password has been changed by the owner\n";
+        room->broadcast(sysMsg, clientSocket);
     }
 
-    cout << "[CMD] Client " << clientSocket << " changed password for room: "
-        << roomId << endl;
+    LOG_INFO("[CMD] Client " << clientSocket << " changed password for room: "
+        << roomId);
 }
 
-void handleClientCommand(SOCKET clientSocket, const string& command) {
-    stringstream ss(command);
-    string cmd;
-    ss >> cmd;
+// The whole of text must be a number that fits in value
+template <typename T>
+static bool parseNumber(string_view text, T& value) {
+    const char* end = text.data() + text.size();
+    auto result = from_chars(text.data(), end, value);
+    return result.ec == errc() && result.ptr == end;
+}
 
-    if (cmd == "CREATE") {
-        string params;
-        getline(ss, params);
-        handleCreateCommand(clientSocket, params);
-    }
-    else if (cmd == "JOIN") {
-        string params;
-        getline(ss, params);
-        handleJoinCommand(clientSocket, params);
-    }
-    else if (cmd == "SETNAME") {
-        string name;
-        getline(ss, name);
-        handleSetNameCommand(clientSocket, name);
-    }
-    else if (cmd == "LIST") {
-        handleListCommand(clientSocket);
-    }
-    else if (cmd == "GETPASSWORD") {
-        handleGetPasswordCommand(clientSocket);
-    }
-    else if (cmd == "USERS") {
-        handleUsersCommand(clientSocket);
-    }
-    else if (cmd == "KICK") {
-        string params;
-        getline(ss, params);
-        handleKickCommand(clientSocket, params);
-    }
-    else if (cmd == "BAN") {
-        string params;
-        getline(ss, params);
-        handleBanCommand(clientSocket, params);
-    }
-    else if (cmd == "TRANSFER") {
-        string params;
-        getline(ss, params);
-        handleTransferCommand(clientSocket, params);
+void handleHistoryCommand(SOCKET clientSocket, string_view params) {
+    ClientInfo client;
+    g_clients.get(clientSocket, client);
+    SymbolRef roomId = client.getRoomId();
+
+    if (roomId.empty()) {
+        sendToClient(clientSocket, "ERROR: You are not in a room\n");
+        return;
     }
-    else if (cmd == "LEAVE") {
-        handleLeaveCommand(clientSocket);
+
+    // HISTORY [before_id] [count]; before_id 0 or omitted = newest page
+    CommandTokenizer tokens(params);
+    string_view beforeText = tokens.next();
+    string_view countText = tokens.next();
+
+    long long beforeId = 0;
+    int pageSize = DEFAULT_HISTORY_PAGE_SIZE;
+    bool valid = tokens.rest().empty() &&
+        (beforeText.empty() || parseNumber(beforeText, beforeId)) &&
+        (countText.empty() || parseNumber(countText, pageSize));
+
+    if (!valid || beforeId < 0 || pageSize < 1 || pageSize > MAX_HISTORY_PAGE_SIZE) {
+        sendToClient(clientSocket, "ERROR: Usage: HISTORY [before_id] [count], count 1-" +
+            to_string(MAX_HISTORY_PAGE_SIZE) + "\n");
+        return;
     }
-    else if (cmd == "FORCELEAVE") {
-        handleForceLeaveCommand(clientSocket);
+
+    if (!g_database) {
+        sendToClient(clientSocket, "ERROR: History is not available\n");
+        return;
     }
-    else if (cmd == "CHANGEPASSWORD") {
-        string params;
-        getline(ss, params);
-        handleChangePasswordCommand(clientSocket, params);
+
+    HistoryPage page = g_database->getMessageHistoryPage(roomId.str(), beforeId, pageSize);
+
+    vector<SharedPayload> reply;
+    reply.reserve(page.lines.size() + 2);
+    reply.push_back(makeServerTextPayload("HISTORY_PAGE_START:" +
+        to_string(page.lines.size()) + "\n"));
+    for (const string& line : page.lines) {
+        reply.push_back(makeServerTextPayload(line));
     }
-    else {
+    reply.push_back(makeServerTextPayload("HISTORY_PAGE_END:" +
+        to_string(page.nextBeforeId) + "\n"));
+    sendToClient(clientSocket, reply);
+
+    LOG_DEBUG("[CMD] Client " << clientSocket << " requested " << page.lines.size()
+        << " history lines in room " << roomId);
+}
+
+// Indexed by CommandId; commands without parameters ignore the rest of the line
+typedef void (*CommandHandler)(SOCKET clientSocket, string_view params);
+
+static constexpr CommandHandler s_commandHandlers[COMMAND_COUNT] = {
+    handleCreateCommand,
+    handleJoinCommand,
+    handleSetNameCommand,
+    [](SOCKET clientSocket, string_view) { handleListCommand(clientSocket); },
+    [](SOCKET clientSocket, string_view) { handleGetPasswordCommand(clientSocket); },
+    [](SOCKET clientSocket, string_view) { handleUsersCommand(clientSocket); },
+    handleKickCommand,
+    handleBanCommand,
+    handleTransferCommand,
+    [](SOCKET clientSocket, string_view) { handleLeaveCommand(clientSocket); },
+    [](SOCKET clientSocket, string_view) { handleForceLeaveCommand(clientSocket); },
+    handleChangePasswordCommand,
+    handleHistoryCommand
+};
+
+void handleClientCommand(SOCKET clientSocket, string_view command) {
+    CommandTokenizer tokens(command);
+    CommandId id = findCommand(tokens.next());
+
+    ScopedTimer timer(g_serverMetrics.commandLatency(id));
+
+    if (id == CommandId::Unknown) {
         sendToClient(clientSocket, "ERROR: Unknown command\n");
+        return;
     }
+
+    s_commandHandlers[static_cast<size_t>(id)](clientSocket, tokens.rest());
 }
 
 // ============================================================================
 // MESSAGE BROADCASTING
 // ============================================================================
 
-void broadcastMessages() {
-    cout << "[THREAD] Broadcaster thread started" << endl;
+// Broadcaster worker threads, one per shard
+static vector<thread> s_broadcasterThreads;
 
-    while (!g_shutdownRequested) {
-        Message message;
+bool enqueueMessage(Message message) {
+    // Same room -> same shard -> same worker, which preserves per-room order
+    size_t shardIndex = hash<Symbol>()(message.getRoomId()) % g_messageShards.size();
+    return g_messageShards[shardIndex]->push(move(message));
+}
 
-        {
-            unique_lock<mutex> lock(g_queueMutex);
-            g_messageCV.wait_for(lock, chrono::milliseconds(100), [] {
-                return !g_messageQueue.empty() || g_shutdownRequested;
-                });
+void startBroadcasters(int threadCount) {
+    for (int i = 0; i < threadCount; i++) {
+        g_messageShards.push_back(make_unique<MessageShard>());
+    }
 
-            if (g_shutdownRequested && g_messageQueue.empty()) {
-                break;
-            }
+    for (int i = 0; i < threadCount; i++) {
+        s_broadcasterThreads.emplace_back(broadcastMessages, static_cast<size_t>(i));
+    }
+}
 
-            if (g_messageQueue.empty()) {
-                continue;
-            }
+void stopBroadcasters() {
+    for (auto& shard : g_messageShards) {
+        shard->notifyAll();
+    }
 
-            message = g_messageQueue.front();
-            g_messageQueue.pop();
+    for (thread& worker : s_broadcasterThreads) {
+        if (worker.joinable()) {
+            worker.join();
         }
+    }
+    s_broadcasterThreads.clear();
 
-        {
-            lock_guard<mutex> lock(g_chatRoomsMutex);
-            auto it = g_chatRooms.find(message.getRoomId());
-            if (it != g_chatRooms.end()) {
-                if (message.isPrivate()) {
-                    // Handle private message
-                    SOCKET recipientSocket = findClientByUsername(
-                        message.getRecipientName(),
-                        message.getRoomId()
-                    );
+    for (size_t i = 0; i < g_messageShards.size(); i++) {
+        LOG_INFO("[SHUTDOWN] Broadcaster shard " << i << ": "
+            << g_messageShards[i]->getTotalMessages() << " messages, "
+            << g_messageShards[i]->getWakeups() << " wakeups, peak queue depth "
+            << g_messageShards[i]->getPeakDepth() << ", dropped "
+            << g_messageShards[i]->getDroppedMessages());
+    }
+}
 
-                    if (recipientSocket == INVALID_SOCKET) {
-                        string errorMsg = "ERROR: User '" +
-                            message.getRecipientName() +
-                            "' not found in this room\n";
-                        sendToClient(message.getSenderSocket(), errorMsg);
-                        cout << "[PM] Failed - recipient not found: "
-                            << message.getRecipientName() << endl;
-                    }
-                    else {
-                        string timestamp = getCurrentTimestamp();
-                        string formattedMessage = timestamp + " PM_FROM:" +
-                            message.getSenderName() + ":" +
-                            message.getContent() + "\n";
-                        sendToClient(recipientSocket, formattedMessage);
-
-                        string confirmMessage = timestamp + " PM_SENT:" +
-                            message.getRecipientName() + ":" +
-                            message.getContent() + "\n";
-                        sendToClient(message.getSenderSocket(), confirmMessage);
-
-                        // Save private message to database
-                        if (g_database) {
-                            g_database->saveMessage(
-                                message.getRoomId(),
-                                message.getSenderName(),
-                                message.getContent(),
-                                true,
-                                message.getRecipientName()
-                            );
-                        }
-
-                        cout << "[PM] " << timestamp << " "
-                            << message.getSenderName() << " -> "
-                            << message.getRecipientName() << ": "
-                            << message.getContent() << endl;
-                    }
-                }
-                else {
-                    // Handle regular broadcast message
-                    string timestamp = getCurrentTimestamp();
-                    string formattedMessage = timestamp + " " +
-                        message.getSenderName() + ": " +
-                        message.getContent() + "\n";
-
-                    it->second->addMessageToHistory(formattedMessage);
-                    it->second->broadcast(formattedMessage, message.getSenderSocket());
-
-                    // Save message to database
-                    if (g_database) {
-                        g_database->saveMessage(
-                            message.getRoomId(),
-                            message.getSenderName(),
-                            message.getContent(),
-                            false,
-                            ""
-                        );
-                    }
-
-                    cout << "[BROADCAST] Room " << message.getRoomId() << " - "
-                        << timestamp << " " << message.getSenderName() << ": "
-                        << message.getContent() << endl;
+// Delivers one queued message: room broadcast or private message. The
+// content is moved on to the persistence writer at the end.
+static void deliverMessage(Message& message) {
+    shared_ptr<ChatRoom> room = findRoom(message.getRoomId());
+
+    if (room) {
+        const SymbolRef& senderName = message.getSenderName();
+        const SymbolRef& recipientName = message.getRecipientName();
+
+        if (message.isPrivate()) {
+            // Handle private message
+            SOCKET recipientSocket = findClientByUsername(recipientName,
+                message.getRoomId());
+
+            if (recipientSocket == INVALID_SOCKET) {
+                string errorMsg = "ERROR: User '" + recipientName.str() +
+                    "' not found in this room\n";
+                sendToClient(message.getSenderSocket(), errorMsg);
+                LOG_DEBUG("[PM] Failed - recipient not found: " << recipientName);
+            }
+            else {
+                string timestamp = getCurrentTimestamp();
+                string formattedMessage = timestamp + " PM_FROM:" +
+                    senderName.str() + ":" +
+                    message.getContent() + "\n";
+                sendToClient(recipientSocket, formattedMessage);
+
+                string confirmMessage = timestamp + " PM_SENT:" +
+                    recipientName.str() + ":" +
+                    message.getContent() + "\n";
+                sendToClient(message.getSenderSocket(), confirmMessage);
+
+                LOG_DEBUG("[PM] " << timestamp << " "
+                    << senderName << " -> "
+                    << recipientName << ": "
+                    << message.getContent());
+
+                // Queue private message for the database writer
+                if (g_persistence) {
+                    g_persistence->saveMessage(
+                        message.getRoomId(),
+                        senderName,
+                        message.takeContent(),
+                        true,
+                        recipientName
+                    );
                 }
             }
         }
+        else {
+            // Handle regular broadcast message
+            string timestamp = getCurrentTimestamp();
+            string formattedMessage = timestamp + " " +
+                senderName.str() + ": " +
+                message.getContent() + "\n";
+
+            // Encode once; history and every recipient share the buffer
+            SharedPayload payload = makeServerTextPayload(formattedMessage);
+            room->addMessageToHistory(payload);
+            room->broadcast(payload, message.getSenderSocket());
+
+            LOG_DEBUG("[BROADCAST] Room " << message.getRoomId() << " - "
+                << timestamp << " " << senderName << ": "
+                << message.getContent());
+
+            // Queue message for the database writer
+            if (g_persistence) {
+                g_persistence->saveMessage(
+                    message.getRoomId(),
+                    senderName,
+                    message.takeContent(),
+                    false,
+                    SymbolRef()
+                );
+            }
+        }
     }
+}
+
+void broadcastMessages(size_t shardIndex) {
+    LOG_INFO("[THREAD] Broadcaster " << shardIndex << " started");
+    MessageShard& shard = *g_messageShards[shardIndex];
+
+    vector<Message> batch;
+    batch.reserve(BROADCAST_BATCH_SIZE);
+
+    while (true) {
+        batch.clear();
 
-    cout << "[THREAD] Broadcaster thread exiting" << endl;
+        if (shard.waitAndPopBatch(batch, BROADCAST_BATCH_SIZE, chrono::milliseconds(100)) == 0) {
+            if (g_shutdownRequested && shard.getDepth() == 0) {
+                break;
+            }
+            continue;
+        }
+
+        ScopedTimer timer(g_serverMetrics.broadcastBatch);
+        for (Message& message : batch) {
+            deliverMessage(message);
+        }
+    }
+
+    LOG_INFO("[THREAD] Broadcaster " << shardIndex << " exiting");
 }
 
 // ============================================================================
 // CLIENT HANDLING
 // ============================================================================
 
-void handleClientDisconnect(SOCKET clientSocket, vector<WSAPOLLFD>& pollFds,
-    mutex& pollFdsMutex) {
-    cout << "[DISCONNECT] Client " << clientSocket << " disconnected" << endl;
+void handleClientDisconnect(SOCKET clientSocket, EventLoop& eventLoop) {
+    LOG_INFO("[DISCONNECT] Client " << clientSocket << " disconnected");
 
     removeClientFromRoom(clientSocket);
 
-    {
-        lock_guard<mutex> clientLock(g_clientsMutex);
-        g_clients.erase(clientSocket);
+    ClientInfo client;
+    if (g_clients.get(clientSocket, client)) {
+        releaseUsername(client.getUsername(), clientSocket);
     }
+    g_clients.erase(clientSocket);
+
+    g_connections.erase(clientSocket);
 
+    eventLoop.removeSocket(clientSocket);
     closesocket(clientSocket);
+}
 
-    {
-        lock_guard<mutex> lock(pollFdsMutex);
-        for (auto it = pollFds.begin(); it != pollFds.end(); ++it) {
-            if (it->fd == clientSocket) {
-                pollFds.erase(it);
-                break;
-            }
+// Second half of the flood check for a parsed chat or private message;
+// the sender's own buckets were charged while its ClientInfo was locked.
+// Charges the room's buckets, refunding the sender's if the room refuses,
+// counts any drop and tells the sender with RATE_LIMITED once per run of
+// drops so the replies can't become a flood of their own.
+static bool passesRateLimits(SOCKET clientSocket, Symbol roomId,
+    bool clientAdmitted, size_t bytes) {
+    const char* notice = nullptr;
+
+    if (!clientAdmitted) {
+        g_serverMetrics.rateLimitedByClient.add();
+        notice = "RATE_LIMITED:client\n";
+    }
+    else {
+        if (g_config.roomMsgRate == 0 && g_config.roomByteRate == 0) {
+            return true;
+        }
+
+        shared_ptr<ChatRoom> room = findRoom(roomId);
+        if (!room || room->admitMessage(bytes)) {
+            return true;
         }
+        g_serverMetrics.rateLimitedByRoom.add();
+        notice = "RATE_LIMITED:room\n";
     }
+
+    bool notify = false;
+    g_clients.update(clientSocket, [&](ClientInfo& client) {
+        if (clientAdmitted) {
+            client.refundMessage(bytes);
+        }
+        notify = client.markRateLimited();
+        });
+
+    if (notify) {
+        sendToClient(clientSocket, notice);
+    }
+    return false;
 }
 
-void handleClientMessage(SOCKET clientSocket, const char* buffer, int bytesReceived) {
-    string receivedText(buffer, bytesReceived);
-    receivedText = trim(receivedText);
+void handleClientMessage(SOCKET clientSocket, const Frame& frame) {
+    string_view payload = trimView(frame.payload);
 
-    if (receivedText.empty()) {
+    if (payload.empty()) {
         return;
     }
 
-    if (receivedText[0] == '/') {
-        handleClientCommand(clientSocket, receivedText.substr(1));
+    if (frame.opcode == Opcode::Command) {
+        handleClientCommand(clientSocket, payload);
     }
-    else if (receivedText[0] == '@') {
-        // Private message format: @username message text
-        size_t spacePos = receivedText.find(' ');
-        if (spacePos == string::npos || spacePos == 1) {
+    else if (frame.opcode == Opcode::PrivateMessage) {
+        // Private message payload: username message text
+        size_t spacePos = payload.find(' ');
+        if (spacePos == string_view::npos || spacePos == 0) {
             sendToClient(clientSocket,
                 "ERROR: Invalid private message format. Use: @username message\n");
             return;
         }
 
-        string recipientName = receivedText.substr(1, spacePos - 1);
-        string messageContent = receivedText.substr(spacePos + 1);
-
-        recipientName = trim(recipientName);
-        messageContent = trim(messageContent);
+        string_view recipientName = trimView(payload.substr(0, spacePos));
+        string_view messageContent = trimView(payload.substr(spacePos + 1));
 
         if (recipientName.empty() || messageContent.empty()) {
             sendToClient(clientSocket,
@@ -1032,24 +1075,36 @@ void handleClientMessage(SOCKET clientSocket, const char* buffer, int bytesRecei
             return;
         }
 
-        string roomId;
-        string username;
+        SymbolRef roomId;
+        SymbolRef username;
+        bool clientAdmitted = false;
 
-        {
-            lock_guard<mutex> lock(g_clientsMutex);
-            auto it = g_clients.find(clientSocket);
-            if (it != g_clients.end()) {
-                roomId = it->second.getRoomId();
-                username = it->second.getUsername();
+        g_clients.update(clientSocket, [&](ClientInfo& client) {
+            roomId = client.getRoomId();
+            username = client.getUsername();
+            if (!roomId.empty()) {
+                clientAdmitted = client.admitMessage(payload.size());
             }
-        }
+            });
 
         if (roomId.empty()) {
             sendToClient(clientSocket, "ERROR: You must join a room first\n");
             return;
         }
 
-        if (recipientName == username) {
+        if (!passesRateLimits(clientSocket, roomId, clientAdmitted, payload.size())) {
+            return;
+        }
+
+        // A name that was never interned belongs to nobody
+        SymbolRef recipient = g_symbols.find(recipientName);
+        if (recipient.empty()) {
+            sendToClient(clientSocket, "ERROR: User '" + string(recipientName) +
+                "' not found in this room\n");
+            return;
+        }
+
+        if (recipient == username) {
             sendToClient(clientSocket,
                 "ERROR: You cannot send a private message to yourself\n");
             return;
@@ -1057,47 +1112,50 @@ void handleClientMessage(SOCKET clientSocket, const char* buffer, int bytesRecei
 
         Message msg;
         msg.setSenderSocket(clientSocket);
-        msg.setContent(messageContent);
-        msg.setRoomId(roomId);
-        msg.setSenderName(username);
+        msg.setContent(string(messageContent));
+        msg.setRoomId(move(roomId));
+        msg.setSenderName(move(username));
         msg.setIsPrivate(true);
-        msg.setRecipientName(recipientName);
+        msg.setRecipientName(move(recipient));
 
-        {
-            lock_guard<mutex> lock(g_queueMutex);
-            g_messageQueue.push(msg);
+        if (!enqueueMessage(move(msg))) {
+            sendToClient(clientSocket, "ERROR: Server is busy, message dropped\n");
         }
-        g_messageCV.notify_one();
     }
-    else {
-        string roomId;
-        string username;
-
-        {
-            lock_guard<mutex> lock(g_clientsMutex);
-            auto it = g_clients.find(clientSocket);
-            if (it != g_clients.end()) {
-                roomId = it->second.getRoomId();
-                username = it->second.getUsername();
+    else if (frame.opcode == Opcode::Chat) {
+        SymbolRef roomId;
+        SymbolRef username;
+        bool clientAdmitted = false;
+
+        g_clients.update(clientSocket, [&](ClientInfo& client) {
+            roomId = client.getRoomId();
+            username = client.getUsername();
+            if (!roomId.empty()) {
+                clientAdmitted = client.admitMessage(payload.size());
             }
-        }
+            });
 
         if (roomId.empty()) {
             sendToClient(clientSocket, "ERROR: You must join a room first\n");
             return;
         }
 
+        if (!passesRateLimits(clientSocket, roomId, clientAdmitted, payload.size())) {
+            return;
+        }
+
         Message msg;
         msg.setSenderSocket(clientSocket);
-        msg.setContent(receivedText);
-        msg.setRoomId(roomId);
-        msg.setSenderName(username);
+        msg.setContent(string(payload));
+        msg.setRoomId(move(roomId));
+        msg.setSenderName(move(username));
         msg.setIsPrivate(false);
 
-        {
-            lock_guard<mutex> lock(g_queueMutex);
-            g_messageQueue.push(msg);
+        if (!enqueueMessage(move(msg))) {
+            sendToClient(clientSocket, "ERROR: Server is busy, message dropped\n");
         }
-        g_messageCV.notify_one();
+    }
+    else {
+        sendToClient(clientSocket, "ERROR: Unsupported message type\n");
     }
 }
\ No newline at end of file
@@ -1,43 +1,51 @@
 #pragma once
 #include "Common.h"
+#include "Protocol.h"
+#include "SymbolTable.h"
 
 // ============================================================================
 // UTILITY FUNCTIONS (Server-Specific)
 // ============================================================================
-bool isUsernameAvailable(const string& username, SOCKET excludeSocket = INVALID_SOCKET);
-SOCKET findClientByUsername(const string& username, const string& roomId);
+bool isUsernameAvailable(Symbol username, SOCKET excludeSocket = INVALID_SOCKET);
+SOCKET findClientByUsername(Symbol username, Symbol roomId);
+shared_ptr<ChatRoom> findRoom(Symbol roomId);
+void releaseUsername(Symbol username, SOCKET clientSocket);
 
 // ============================================================================
 // ROOM MANAGEMENT
 // ============================================================================
-void cleanupEmptyRoom(const string& roomId);
+void cleanupEmptyRoom(const SymbolRef& roomId);
 void removeClientFromRoom(SOCKET clientSocket);
 
 // ============================================================================
 // COMMAND HANDLERS
 // ============================================================================
-void handleCreateCommand(SOCKET clientSocket, const string& params);
-void handleJoinCommand(SOCKET clientSocket, const string& params);
-void handleSetNameCommand(SOCKET clientSocket, const string& name);
+void handleCreateCommand(SOCKET clientSocket, string_view params);
+void handleJoinCommand(SOCKET clientSocket, string_view params);
+void handleSetNameCommand(SOCKET clientSocket, string_view name);
 void handleListCommand(SOCKET clientSocket);
 void handleGetPasswordCommand(SOCKET clientSocket);
 void handleUsersCommand(SOCKET clientSocket);
-void handleKickCommand(SOCKET clientSocket, const string& params);
-void handleBanCommand(SOCKET clientSocket, const string& params);
-void handleTransferCommand(SOCKET clientSocket, const string& params);
+void handleKickCommand(SOCKET clientSocket, string_view params);
+void handleBanCommand(SOCKET clientSocket, string_view params);
+void handleTransferCommand(SOCKET clientSocket, string_view params);
 void handleLeaveCommand(SOCKET clientSocket);
 void handleForceLeaveCommand(SOCKET clientSocket);
-void handleChangePasswordCommand(SOCKET clientSocket, const string& params);
-void handleClientCommand(SOCKET clientSocket, const string& command);
+void handleChangePasswordCommand(SOCKET clientSocket, string_view params);
+void handleHistoryCommand(SOCKET clientSocket, string_view params);
+void handleClientCommand(SOCKET clientSocket, string_view command);
 
 // ============================================================================
 // MESSAGE BROADCASTING
 // ============================================================================
-void broadcastMessages();
+// Returns false if the target shard is full and the message was dropped
+bool enqueueMessage(Message message);
+void startBroadcasters(int threadCount);
+void stopBroadcasters();
+void broadcastMessages(size_t shardIndex);
 
 // ============================================================================
 // CLIENT HANDLING
 // ============================================================================
-void handleClientDisconnect(SOCKET clientSocket, vector<WSAPOLLFD>& pollFds,
-    mutex& pollFdsMutex);
-void handleClientMessage(SOCKET clientSocket, const char* buffer, int bytesReceived);
\ No newline at end of file
+void handleClientDisconnect(SOCKET clientSocket, EventLoop& eventLoop);
+void handleClientMessage(SOCKET clientSocket, const Frame& frame);
\ No newline at end of file
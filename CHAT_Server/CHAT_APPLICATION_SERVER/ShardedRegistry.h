@@ -0,0 +1,138 @@
+#pragma once
+#include "Common.h"
+#include "LockOrder.h"
+#include <unordered_map>
+
+// Concurrent hash map split into independently locked shards. Each shard
+// has a reader/writer lock, so lookups in different shards never contend
+// and lookups in the same shard only contend with writers.
+//
+// Entries are only reachable through the accessors below; callbacks run
+// while the shard lock is held and must not touch another registry with
+// an equal or lower LockRank (see LockOrder.h).
+template <typename Key, typename Value>
+class ShardedRegistry {
+private:
+    struct alignas(64) Shard {
+        mutable RankedSharedMutex mutex;
+        unordered_map<Key, Value> entries;
+
+        explicit Shard(LockRank rank) : mutex(rank) {}
+    };
+
+    vector<unique_ptr<Shard>> m_shards;
+
+    Shard& shardFor(const Key& key) const {
+        return *m_shards[hash<Key>()(key) % m_shards.size()];
+    }
+
+public:
+    explicit ShardedRegistry(LockRank rank, size_t shardCount = REGISTRY_SHARD_COUNT) {
+        for (size_t i = 0; i < shardCount; i++) {
+            m_shards.push_back(make_unique<Shard>(rank));
+        }
+    }
+
+    ShardedRegistry(const ShardedRegistry&) = delete;
+    ShardedRegistry& operator=(const ShardedRegistry&) = delete;
+
+    // Copies the entry into value. Returns false if the key is absent.
+    bool get(const Key& key, Value& value) const {
+        Shard& shard = shardFor(key);
+        shared_lock<RankedSharedMutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    // Runs fn(const Value&) under the shard's shared lock
+    template <typename Fn>
+    bool read(const Key& key, Fn&& fn) const {
+        Shard& shard = shardFor(key);
+        shared_lock<RankedSharedMutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            return false;
+        }
+        fn(it->second);
+        return true;
+    }
+
+    // Runs fn(Value&) under the shard's exclusive lock
+    template <typename Fn>
+    bool update(const Key& key, Fn&& fn) {
+        Shard& shard = shardFor(key);
+        lock_guard<RankedSharedMutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            return false;
+        }
+        fn(it->second);
+        return true;
+    }
+
+    // Inserts or replaces the entry
+    void insert(const Key& key, Value value) {
+        Shard& shard = shardFor(key);
+        lock_guard<RankedSharedMutex> lock(shard.mutex);
+        shard.entries[key] = move(value);
+    }
+
+    // Inserts only if the key is free. Returns false if it was taken.
+    bool tryInsert(const Key& key, Value value) {
+        Shard& shard = shardFor(key);
+        lock_guard<RankedSharedMutex> lock(shard.mutex);
+        return shard.entries.emplace(key, move(value)).second;
+    }
+
+    bool erase(const Key& key) {
+        Shard& shard = shardFor(key);
+        lock_guard<RankedSharedMutex> lock(shard.mutex);
+        return shard.entries.erase(key) > 0;
+    }
+
+    // Erases the entry only if pred(const Value&) holds, atomically with
+    // respect to read()/update() on the same key
+    template <typename Pred>
+    bool eraseIf(const Key& key, Pred&& pred) {
+        Shard& shard = shardFor(key);
+        lock_guard<RankedSharedMutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end() || !pred(it->second)) {
+            return false;
+        }
+        shard.entries.erase(it);
+        return true;
+    }
+
+    // Visits every entry as fn(const Key&, const Value&), one shard at a
+    // time. Not a consistent snapshot across shards.
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& shard : m_shards) {
+            shared_lock<RankedSharedMutex> lock(shard->mutex);
+            for (const auto& pair : shard->entries) {
+                fn(pair.first, pair.second);
+            }
+        }
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& shard : m_shards) {
+            shared_lock<RankedSharedMutex> lock(shard->mutex);
+            total += shard->entries.size();
+        }
+        return total;
+    }
+
+    void clear() {
+        for (auto& shard : m_shards) {
+            lock_guard<RankedSharedMutex> lock(shard->mutex);
+            shard->entries.clear();
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "SymbolTable.h"
+#include "Logger.h"
+
+SymbolTable g_symbols;
+
+ostream& operator<<(ostream& out, Symbol symbol) {
+    return out << symbol.str();
+}
+
+SymbolTable::SymbolTable()
+    : m_mutex(LockRank::SymbolTable)
+    , m_nextId(1)
+    , m_live(0) {
+    for (auto& chunk : m_chunks) {
+        chunk.store(nullptr, memory_order_relaxed);
+    }
+
+    // Slot 0 holds the empty name
+    m_chunks[0].store(new Entry[SYMBOL_CHUNK_SIZE], memory_order_release);
+}
+
+SymbolTable::Entry& SymbolTable::entry(Symbol symbol) const {
+    uint32_t id = symbol.getId();
+    return m_chunks[id / SYMBOL_CHUNK_SIZE].load(memory_order_acquire)[id % SYMBOL_CHUNK_SIZE];
+}
+
+SymbolRef SymbolTable::intern(string_view text) {
+    if (text.empty()) {
+        return SymbolRef();
+    }
+
+    SymbolRef existing = find(text);
+    if (!existing.empty()) {
+        return existing;
+    }
+
+    lock_guard<RankedSharedMutex> lock(m_mutex);
+
+    // Another thread may have added it between the two locks
+    auto it = m_symbols.find(text);
+    if (it != m_symbols.end()) {
+        entry(it->second).references.fetch_add(1, memory_order_relaxed);
+        return SymbolRef(it->second);
+    }
+
+    uint32_t id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+    } else {
+        size_t chunkIndex = m_nextId / SYMBOL_CHUNK_SIZE;
+        if (chunkIndex >= SYMBOL_MAX_CHUNKS) {
+            LOG_ERROR("[ERROR] Symbol table is full, cannot intern: " << text);
+            return SymbolRef();
+        }
+
+        if (!m_chunks[chunkIndex].load(memory_order_relaxed)) {
+            m_chunks[chunkIndex].store(new Entry[SYMBOL_CHUNK_SIZE], memory_order_release);
+        }
+        id = m_nextId++;
+    }
+
+    // The name is written before the id is handed out, and every reader
+    // gets the id through a lock or queue that orders it after this
+    Symbol symbol(id);
+    Entry& stored = entry(symbol);
+    stored.name.assign(text);
+    stored.references.store(1, memory_order_relaxed);
+    m_symbols.emplace(string_view(stored.name), symbol);
+    m_live.fetch_add(1, memory_order_relaxed);
+    return SymbolRef(symbol);
+}
+
+SymbolRef SymbolTable::find(string_view text) const {
+    if (text.empty()) {
+        return SymbolRef();
+    }
+
+    // Counted under the lock, so reclaim() can't free the id in between
+    shared_lock<RankedSharedMutex> lock(m_mutex);
+    auto it = m_symbols.find(text);
+    if (it == m_symbols.end()) {
+        return SymbolRef();
+    }
+    entry(it->second).references.fetch_add(1, memory_order_relaxed);
+    return SymbolRef(it->second);
+}
+
+void SymbolTable::retain(Symbol symbol) {
+    entry(symbol).references.fetch_add(1, memory_order_relaxed);
+}
+
+void SymbolTable::release(Symbol symbol) {
+    if (entry(symbol).references.fetch_sub(1, memory_order_acq_rel) == 1) {
+        reclaim(symbol);
+    }
+}
+
+void SymbolTable::reclaim(Symbol symbol) {
+    lock_guard<RankedSharedMutex> lock(m_mutex);
+
+    // find() may have revived the name since the count hit zero, or another
+    // release already freed the id (and intern() perhaps reused it)
+    Entry& stored = entry(symbol);
+    if (stored.references.load(memory_order_acquire) != 0) {
+        return;
+    }
+    auto it = m_symbols.find(stored.name);
+    if (it == m_symbols.end() || it->second != symbol) {
+        return;
+    }
+
+    m_symbols.erase(it);
+    string().swap(stored.name);
+    m_freeIds.push_back(symbol.getId());
+    m_live.fetch_sub(1, memory_order_relaxed);
+}
+
+const string& SymbolTable::name(Symbol symbol) const {
+    return entry(symbol).name;
+}
+
+size_t SymbolTable::size() const {
+    return m_live.load(memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+#pragma once
+#include "Common.h"
+#include "LockOrder.h"
+#include <array>
+#include <unordered_map>
+
+// ============================================================================
+// SYMBOLS
+// ============================================================================
+// Usernames and room IDs are interned once, when a name is set or a room is
+// created, and passed around as 32-bit Symbols from then on. Registries,
+// rooms and queued messages key and compare by the integer; the text is
+// only looked up where it is written out.
+//
+// A name stays interned while a SymbolRef to it exists. Clients, rooms,
+// bans and queued messages hold SymbolRefs; a plain Symbol is a borrowed
+// handle, valid only while something else holds a reference. When the
+// last reference goes, the id is recycled, so the table is bounded by the
+// names in use rather than every name ever seen (chat_symbols on the
+// metrics endpoint).
+
+class Symbol {
+private:
+    uint32_t m_id;
+
+public:
+    constexpr Symbol() : m_id(0) {}
+    constexpr explicit Symbol(uint32_t id) : m_id(id) {}
+
+    constexpr uint32_t getId() const { return m_id; }
+
+    // The empty Symbol stands for "no name" / "no room"
+    constexpr bool empty() const { return m_id == 0; }
+
+    // The interned text; never locks
+    const string& str() const;
+};
+
+// Free functions, so SymbolRefs compare through their conversion too
+constexpr bool operator==(Symbol a, Symbol b) { return a.getId() == b.getId(); }
+constexpr bool operator!=(Symbol a, Symbol b) { return a.getId() != b.getId(); }
+
+ostream& operator<<(ostream& out, Symbol symbol);
+
+namespace std {
+template <>
+struct hash<Symbol> {
+    size_t operator()(Symbol symbol) const noexcept {
+        return symbol.getId();
+    }
+};
+}
+
+// Owning handle: keeps its name interned until it is destroyed or
+// reassigned. Copies take another reference.
+class SymbolRef {
+private:
+    Symbol m_symbol;
+
+    // Takes over a reference the table has already counted
+    explicit SymbolRef(Symbol adopted) : m_symbol(adopted) {}
+    friend class SymbolTable;
+
+public:
+    SymbolRef() = default;
+    SymbolRef(const SymbolRef& other);
+    SymbolRef(SymbolRef&& other) noexcept : m_symbol(other.m_symbol) {
+        other.m_symbol = Symbol();
+    }
+    SymbolRef& operator=(SymbolRef other) noexcept {
+        swap(m_symbol, other.m_symbol);
+        return *this;
+    }
+    ~SymbolRef();
+
+    Symbol get() const { return m_symbol; }
+    operator Symbol() const { return m_symbol; }
+
+    bool empty() const { return m_symbol.empty(); }
+    const string& str() const { return m_symbol.str(); }
+};
+
+class SymbolTable {
+private:
+    struct Entry {
+        string name;
+        atomic<uint32_t> references;
+
+        Entry() : references(0) {}
+    };
+
+    mutable RankedSharedMutex m_mutex;
+    unordered_map<string_view, Symbol> m_symbols;   // Views into m_chunks
+    vector<uint32_t> m_freeIds;
+
+    // Entries by id, in blocks that are never moved or freed, so str() and
+    // reference counting don't lock. Id 0 is the empty name.
+    array<atomic<Entry*>, SYMBOL_MAX_CHUNKS> m_chunks;
+    uint32_t m_nextId;
+    atomic<size_t> m_live;
+
+    Entry& entry(Symbol symbol) const;
+
+    // Frees symbol's id once its last reference is gone. Several threads
+    // may race here for one id; only one frees it.
+    void reclaim(Symbol symbol);
+
+public:
+    SymbolTable();
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    // A reference to text, interning it if it is new. Empty for empty
+    // text, or if the table is full.
+    SymbolRef intern(string_view text);
+
+    // A reference to text if it is interned, otherwise an empty one. Use
+    // this for names typed by clients that only refer to existing users
+    // and rooms, so lookups can't grow the table.
+    SymbolRef find(string_view text) const;
+
+    // For SymbolRef; symbol must already have a live reference
+    void retain(Symbol symbol);
+    void release(Symbol symbol);
+
+    const string& name(Symbol symbol) const;
+
+    // Names currently interned
+    size_t size() const;
+};
+
+extern SymbolTable g_symbols;
+
+inline const string& Symbol::str() const {
+    return g_symbols.name(*this);
+}
+
+inline SymbolRef::SymbolRef(const SymbolRef& other)
+    : m_symbol(other.m_symbol) {
+    if (!m_symbol.empty()) {
+        g_symbols.retain(m_symbol);
+    }
+}
+
+inline SymbolRef::~SymbolRef() {
+    if (!m_symbol.empty()) {
+        g_symbols.release(m_symbol);
+    }
+}
\ No newline at end of file
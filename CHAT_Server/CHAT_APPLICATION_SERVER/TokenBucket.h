@@ -0,0 +1,65 @@
+#pragma once
+#include "Common.h"
+#include <algorithm>
+
+// Classic token bucket: holds up to capacity tokens and refills at
+// ratePerSecond. Each admitted event takes a token; when the bucket is
+// empty the caller waits or rejects. Bursts up to capacity pass at once,
+// the long-run rate never exceeds ratePerSecond.
+//
+// Not thread-safe; each bucket belongs to one thread or is guarded by its
+// owner's lock.
+class TokenBucket {
+private:
+    double m_ratePerSecond;
+    double m_capacity;
+    double m_tokens;
+    chrono::steady_clock::time_point m_lastRefill;
+
+    void refill(chrono::steady_clock::time_point now) {
+        chrono::duration<double> elapsed = now - m_lastRefill;
+        m_tokens = min(m_capacity, m_tokens + elapsed.count() * m_ratePerSecond);
+        m_lastRefill = now;
+    }
+
+public:
+    // Starts full
+    TokenBucket(double ratePerSecond, double capacity)
+        : m_ratePerSecond(ratePerSecond)
+        , m_capacity(capacity)
+        , m_tokens(capacity)
+        , m_lastRefill(chrono::steady_clock::now()) {
+    }
+
+    // Takes tokens if that many are available
+    bool tryTake(double tokens = 1.0,
+        chrono::steady_clock::time_point now = chrono::steady_clock::now()) {
+        refill(now);
+        if (m_tokens < tokens) {
+            return false;
+        }
+        m_tokens -= tokens;
+        return true;
+    }
+
+    // Puts back tokens taken for an event that was dropped after all
+    void refund(double tokens = 1.0) {
+        m_tokens = min(m_capacity, m_tokens + tokens);
+    }
+
+    // Tokens available right now
+    double available(chrono::steady_clock::time_point now = chrono::steady_clock::now()) {
+        refill(now);
+        return m_tokens;
+    }
+
+    // How long until the next token is available (zero if one is now)
+    chrono::milliseconds timeUntilNext(chrono::steady_clock::time_point now = chrono::steady_clock::now()) {
+        refill(now);
+        if (m_tokens >= 1.0 || m_ratePerSecond <= 0.0) {
+            return chrono::milliseconds(0);
+        }
+        double seconds = (1.0 - m_tokens) / m_ratePerSecond;
+        return chrono::milliseconds(static_cast<long long>(seconds * 1000.0) + 1);
+    }
+};
\ No newline at end of file
@@ -1,21 +1,25 @@
 #include "Utilities.h"
 #include "Globals.h"
+#include "Logger.h"
+#include "Config.h"
+#include "Clock.h"
+#include <charconv>
 
 string getCurrentTimestamp() {
-    auto now = chrono::system_clock::now();
-    time_t nowTime = chrono::system_clock::to_time_t(now);
-    tm localTm;
-    localtime_s(&localTm, &nowTime);
-
-    char buffer[20];
-    strftime(buffer, sizeof(buffer), "[%H:%M:%S]", &localTm);
-    return string(buffer);
+    if (g_config.timestampMode == TimestampMode::EpochMillis) {
+        char buffer[32] = "[@";
+        char* end = to_chars(buffer + 2, buffer + sizeof(buffer) - 1, getEpochMillis()).ptr;
+        *end++ = ']';
+        return string(buffer, end);
+    }
+    return g_clock.getTimestamp();
 }
 
 string generateRoomId() {
-    static random_device rd;
-    static mt19937 gen(rd());
-    static uniform_int_distribution<> dis(100000, 999999);
+    // CREATE runs on every reactor thread, and an engine can't be shared
+    // without a lock, so each thread draws from its own
+    thread_local mt19937 gen(random_device{}());
+    thread_local uniform_int_distribution<> dis(100000, 999999);
     return to_string(dis(gen));
 }
 
@@ -28,23 +32,103 @@ string trim(const string& str) {
     return str.substr(first, (last - first + 1));
 }
 
+string_view trimView(string_view str) {
+    size_t first = str.find_first_not_of(" \t\r\n");
+    if (first == string_view::npos) {
+        return string_view();
+    }
+    size_t last = str.find_last_not_of(" \t\r\n");
+    return str.substr(first, (last - first + 1));
+}
+
+SharedPayload makeServerTextPayload(const string& message) {
+    return make_shared<const string>(encodeFrame(Opcode::ServerText, message));
+}
+
 void sendToClient(SOCKET clientSocket, const string& message) {
-    int result = send(clientSocket, message.c_str(),
-        static_cast<int>(message.length()), 0);
-    if (result == SOCKET_ERROR) {
-        cout << "[ERROR] Failed to send to client " << clientSocket
-            << ": " << WSAGetLastError() << endl;
+    sendToClient(clientSocket, makeServerTextPayload(message));
+}
+
+shared_ptr<Connection> findConnection(SOCKET clientSocket) {
+    shared_ptr<Connection> connection;
+    g_connections.get(clientSocket, connection);
+    return connection;
+}
+
+void sendToClient(SOCKET clientSocket, const SharedPayload& payload) {
+    shared_ptr<Connection> connection = findConnection(clientSocket);
+    if (!connection) {
+        return;
+    }
+
+    if (!connection->enqueue(payload)) {
+        LOG_ERROR("[ERROR] Outbound queue full for client " << clientSocket);
+    }
+}
+
+void sendToClient(SOCKET clientSocket, const vector<SharedPayload>& payloads) {
+    shared_ptr<Connection> connection = findConnection(clientSocket);
+    if (!connection) {
+        return;
+    }
+
+    if (!connection->enqueue(payloads)) {
+        LOG_ERROR("[ERROR] Outbound queue full for client " << clientSocket);
     }
 }
 
+void sendToClients(const vector<shared_ptr<Connection>>& connections,
+    const SharedPayload& payload) {
+    for (const auto& connection : connections) {
+        if (!connection->enqueue(payload)) {
+            LOG_ERROR("[ERROR] Outbound queue full for client "
+                << connection->getSocket());
+        }
+    }
+}
+
+bool setSocketNonBlocking(SOCKET socket) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool setSocketBlocking(SOCKET socket) {
+#ifdef _WIN32
+    u_long mode = 0;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags & ~O_NONBLOCK) == 0;
+#endif
+}
+
 bool initializeWinsock() {
+#ifdef _WIN32
     WSADATA wsaData;
     int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
     if (result != 0) {
-        cout << "[ERROR] WSAStartup failed: " << result << endl;
+        LOG_ERROR("[ERROR] WSAStartup failed: " << result);
         return false;
     }
-    cout << "[INFO] Winsock initialized successfully" << endl;
+    LOG_INFO("[INFO] Winsock initialized successfully");
+#else
+    // A peer closing mid-send must surface as EPIPE, not kill the process
+    signal(SIGPIPE, SIG_IGN);
+
+    // Each client is a descriptor; the usual 1024 soft limit would cap
+    // connections far below --max-connections
+    rlimit limit = {};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    LOG_INFO("[INFO] POSIX sockets initialized successfully");
+#endif
     return true;
 }
 
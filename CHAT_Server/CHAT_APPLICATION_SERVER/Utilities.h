@@ -1,19 +1,47 @@
 #pragma once
 #include "Common.h"
+#include "Protocol.h"
+#include "Connection.h"
 
-// Gets the current time as a formatted string
+// Gets the stamp for a chat line: "[HH:MM:SS]" from the coarse clock,
+// or "[@<epoch ms>]" with --timestamps=epoch-ms
 string getCurrentTimestamp();
 
-// Generates a random 6-digit room ID
+// Generates a random 6-digit room ID. Safe to call from any thread.
 string generateRoomId();
 
 // Trims whitespace from the beginning and end of a string
 string trim(const string& str);
 
-// Safely sends a message to a client socket
+// Same as trim, but returns a view into the original characters
+string_view trimView(string_view str);
+
+// Encodes a message as a shareable ServerText frame
+SharedPayload makeServerTextPayload(const string& message);
+
+// The client's connection, or null if it has already gone
+shared_ptr<Connection> findConnection(SOCKET clientSocket);
+
+// Queues a message for a client socket as a ServerText frame.
+// Delivery happens on the I/O thread, so this never blocks on the socket.
 void sendToClient(SOCKET clientSocket, const string& message);
+void sendToClient(SOCKET clientSocket, const SharedPayload& payload);
+// Queues all frames to the client in one go (one lock, one flush request)
+void sendToClient(SOCKET clientSocket, const vector<SharedPayload>& payloads);
+
+// Queues the same encoded frame for several clients
+void sendToClients(const vector<shared_ptr<Connection>>& connections,
+    const SharedPayload& payload);
+
+// Switches a socket to non-blocking mode
+bool setSocketNonBlocking(SOCKET socket);
+
+// Switches a socket back to blocking mode (accepted sockets inherit
+// non-blocking mode from the listener on Windows)
+bool setSocketBlocking(SOCKET socket);
 
-// Initializes the Winsock library
+// Initializes the Winsock library (on POSIX: ignores SIGPIPE and raises
+// the open-file limit)
 bool initializeWinsock();
 
 // Handles server shutdown signals (Ctrl+C)
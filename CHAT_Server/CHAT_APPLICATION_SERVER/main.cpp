@@ -2,178 +2,312 @@
 #include "Globals.h"
 #include "Utilities.h"
 #include "Server.h"
-#include "ClientInfo.h"
 #include "Database.h"
+#include "PersistenceWriter.h"
+#include "Config.h"
+#include "EventLoop.h"
+#include "Reactor.h"
+#include "AdmissionQueue.h"
+#include "Metrics.h"
+#include "MetricsServer.h"
+#include "Clock.h"
+#include "Logger.h"
+
+// Creates a bound, listening, non-blocking socket on the configured port.
+// With reusePort several sockets can share the port and the kernel
+// load-balances incoming connections between them.
+static SOCKET createListenSocket(bool reusePort) {
+    SOCKET listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSocket == INVALID_SOCKET) {
+        LOG_ERROR("[ERROR] Socket creation failed");
+        return INVALID_SOCKET;
+    }
+
+    setSocketNonBlocking(listenSocket);
+
+#ifndef _WIN32
+    // Allow quick restarts while old connections sit in TIME_WAIT
+    int reuseAddr = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr));
+
+    if (reusePort) {
+        int enable = 1;
+        if (setsockopt(listenSocket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0) {
+            LOG_ERROR("[ERROR] SO_REUSEPORT failed: " << errno);
+            closesocket(listenSocket);
+            return INVALID_SOCKET;
+        }
+    }
+#else
+    (void)reusePort;
+#endif
+
+    sockaddr_in serverAddr = {};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(static_cast<u_short>(g_config.port));
+    serverAddr.sin_addr.s_addr = INADDR_ANY;
+
+    if (bind(listenSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
+        LOG_ERROR("[ERROR] Bind failed: " << WSAGetLastError());
+        closesocket(listenSocket);
+        return INVALID_SOCKET;
+    }
+
+    if (listen(listenSocket, SOMAXCONN) == SOCKET_ERROR) {
+        LOG_ERROR("[ERROR] Listen failed: " << WSAGetLastError());
+        closesocket(listenSocket);
+        return INVALID_SOCKET;
+    }
+
+    return listenSocket;
+}
+
+// Chooses the reactor for a new connection
+static Reactor& pickReactor(vector<unique_ptr<Reactor>>& reactors, size_t& nextReactor) {
+    if (g_config.acceptMode == AcceptMode::LeastLoaded) {
+        size_t best = 0;
+        for (size_t i = 1; i < reactors.size(); i++) {
+            if (reactors[i]->getConnectionCount() < reactors[best]->getConnectionCount()) {
+                best = i;
+            }
+        }
+        return *reactors[best];
+    }
+
+    Reactor& reactor = *reactors[nextReactor];
+    nextReactor = (nextReactor + 1) % reactors.size();
+    return reactor;
+}
+
+int main(int argc, char* argv[]) {
+    if (!parseCommandLine(argc, argv)) {
+        return 1;
+    }
+
+    g_logger.setLevel(g_config.logLevel);
+    g_logger.start(cout);
+    g_clock.start();
 
-int main() {
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
 
     // Initialize database
-    g_database = make_unique<Database>("chatserver.db");
+    g_database = make_unique<Database>("chatserver.db",
+        static_cast<size_t>(g_config.dbReaders));
     if (!g_database->initialize()) {
-        cout << "[ERROR] Database initialization failed" << endl;
+        LOG_ERROR("[ERROR] Database initialization failed");
         return 1;
     }
+    g_database->setSynchronous(durabilityName(g_config.durability));
+
+    g_persistence = make_unique<PersistenceWriter>(*g_database,
+        static_cast<size_t>(g_config.dbBatchSize),
+        chrono::milliseconds(g_config.dbFlushMs), PERSIST_QUEUE_CAPACITY);
 
     if (!initializeWinsock()) {
         return 1;
     }
 
-    SOCKET listenSocket = socket(AF_INET, SOCK_STREAM, 0);
-    if (listenSocket == INVALID_SOCKET) {
-        cout << "[ERROR] Socket creation failed" << endl;
-        WSACleanup();
-        return 1;
+    // In reuseport mode every reactor listens on its own socket and the
+    // main thread only waits for shutdown; otherwise the main thread is
+    // the acceptor and hands connections out
+    bool reusePort = (g_config.acceptMode == AcceptMode::ReusePort);
+    SOCKET listenSocket = INVALID_SOCKET;
+    vector<unique_ptr<Reactor>> reactors;
+
+    for (int i = 0; i < g_config.ioThreads; i++) {
+        SOCKET reactorSocket = INVALID_SOCKET;
+        if (reusePort) {
+            reactorSocket = createListenSocket(true);
+            if (reactorSocket == INVALID_SOCKET) {
+                reactors.clear();
+                WSACleanup();
+                return 1;
+            }
+        }
+        reactors.push_back(make_unique<Reactor>(static_cast<size_t>(i), reactorSocket));
     }
 
-    u_long mode = 1;
-    ioctlsocket(listenSocket, FIONBIO, &mode);
-
-    sockaddr_in serverAddr = {};
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_port = htons(PORT);
-    serverAddr.sin_addr.s_addr = INADDR_ANY;
+    unique_ptr<EventLoop> acceptLoop;
+    unique_ptr<AdmissionQueue> admission;
+    if (!reusePort) {
+        listenSocket = createListenSocket(false);
+        if (listenSocket == INVALID_SOCKET) {
+            WSACleanup();
+            return 1;
+        }
 
-    if (bind(listenSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-        cout << "[ERROR] Bind failed: " << WSAGetLastError() << endl;
-        closesocket(listenSocket);
-        WSACleanup();
-        return 1;
+        acceptLoop = EventLoop::create();
+        acceptLoop->addSocket(listenSocket);
+        admission = make_unique<AdmissionQueue>(listenSocket,
+            g_config.acceptRate, g_config.acceptBurst);
     }
 
-    if (listen(listenSocket, SOMAXCONN) == SOCKET_ERROR) {
-        cout << "[ERROR] Listen failed: " << WSAGetLastError() << endl;
-        closesocket(listenSocket);
-        WSACleanup();
-        return 1;
+    // Monitoring is optional: a busy admin port only costs the endpoint
+    registerServerStateMetrics();
+    unique_ptr<MetricsServer> metricsServer;
+    if (g_config.metricsPort > 0) {
+        metricsServer = make_unique<MetricsServer>(g_config.metricsPort);
+        if (!metricsServer->start()) {
+            LOG_WARN("[WARN] Continuing without the metrics endpoint");
+            metricsServer.reset();
+        }
     }
 
+    // Startup lines first, so the banner isn't interleaved with them
+    g_logger.flush();
+
     cout << "========================================" << endl;
     cout << "  CHAT SERVER WITH PRIVATE ROOMS" << endl;
     cout << "========================================" << endl;
-    cout << "Port: " << PORT << endl;
+    cout << "Port: " << g_config.port << endl;
+    cout << "Event loop: " << reactors[0]->getBackendName() << endl;
+    cout << "I/O threads: " << g_config.ioThreads << " ("
+        << acceptModeName(g_config.acceptMode) << ")" << endl;
+    cout << "Broadcaster threads: " << g_config.broadcasterThreads << endl;
+    cout << "Max connections: " << g_config.maxConnections << ", accept rate: ";
+    if (g_config.acceptRate > 0) {
+        cout << g_config.acceptRate << "/s (burst " << g_config.acceptBurst << ")" << endl;
+    }
+    else {
+        cout << "unlimited" << endl;
+    }
+    cout << "Database commits: every " << g_config.dbBatchSize << " messages or "
+        << g_config.dbFlushMs << " ms (durability "
+        << durabilityName(g_config.durability) << ")" << endl;
+    cout << "Flood limits: " << g_config.clientMsgRate << " msg/s, "
+        << g_config.clientByteRate << " B/s per client; " << g_config.roomMsgRate
+        << " msg/s, " << g_config.roomByteRate << " B/s per room (0 = unlimited)" << endl;
+    cout << "Metrics: ";
+    if (metricsServer) {
+        cout << "http://127.0.0.1:" << g_config.metricsPort << "/metrics" << endl;
+    }
+    else {
+        cout << "disabled" << endl;
+    }
+    cout << "Log level: " << logLevelName(g_config.logLevel) << ", timestamps: "
+        << timestampModeName(g_config.timestampMode) << endl;
     cout << "Press Ctrl+C to shutdown gracefully" << endl;
     cout << "========================================\n" << endl;
 
-    vector<WSAPOLLFD> pollFds;
-    mutex pollFdsMutex;
-
-    WSAPOLLFD listenPollFd = {};
-    listenPollFd.fd = listenSocket;
-    listenPollFd.events = POLLRDNORM;
-    pollFds.push_back(listenPollFd);
+    g_persistence->start();
+    startBroadcasters(g_config.broadcasterThreads);
 
-    thread broadcasterThread(broadcastMessages);
+    for (auto& reactor : reactors) {
+        reactor->start();
+    }
 
-    char buffer[BUFFER_SIZE];
+    vector<IoEvent> events;
+    size_t nextReactor = 0;
 
     while (!g_shutdownRequested) {
-        vector<WSAPOLLFD> currentPollFds;
-
-        {
-            lock_guard<mutex> lock(pollFdsMutex);
-            currentPollFds = pollFds;
+        if (!acceptLoop) {
+            this_thread::sleep_for(chrono::milliseconds(100));
+            continue;
         }
 
-        int pollResult = WSAPoll(currentPollFds.data(),
-            static_cast<ULONG>(currentPollFds.size()), 100);
+        int readyCount = acceptLoop->wait(events, admission->nextTimeoutMs(100));
 
-        if (pollResult == SOCKET_ERROR) {
-            cout << "[ERROR] WSAPoll failed: " << WSAGetLastError() << endl;
+        if (readyCount == SOCKET_ERROR) {
+            LOG_ERROR("[ERROR] " << acceptLoop->getBackendName() << " wait failed: "
+                << WSAGetLastError());
+            g_shutdownRequested = true;
             break;
         }
 
-        if (pollResult == 0) {
-            continue;
-        }
-
-        for (size_t i = 0; i < currentPollFds.size(); i++) {
-            if (currentPollFds[i].revents == 0) {
-                continue;
+        // A failed accept (e.g. EMFILE) is retried even without an event
+        bool listenReady = admission->needsAccept();
+        for (const IoEvent& event : events) {
+            if (event.socket == listenSocket) {
+                listenReady = true;
             }
+        }
 
-            if (i == 0 && (currentPollFds[i].revents & POLLRDNORM)) {
-                SOCKET clientSocket = accept(listenSocket, nullptr, nullptr);
+        if (listenReady) {
+            admission->acceptAll();
+        }
 
-                if (clientSocket != INVALID_SOCKET) {
-                    u_long clientMode = 1;
-                    ioctlsocket(clientSocket, FIONBIO, &clientMode);
+        admission->admit([&](SOCKET clientSocket) {
+            pickReactor(reactors, nextReactor).adopt(clientSocket);
+            });
+    }
 
-                    cout << "[CONNECT] New client connected: " << clientSocket << endl;
+    LOG_INFO("\n[SHUTDOWN] Initiating shutdown sequence...");
 
-                    {
-                        lock_guard<mutex> clientLock(g_clientsMutex);
-                        g_clients[clientSocket] = ClientInfo(clientSocket);
-                    }
+    // The endpoint samples broadcaster and persistence state, so it goes
+    // before either is torn down
+    if (metricsServer) {
+        metricsServer->stop();
+        LOG_INFO("[SHUTDOWN] Metrics endpoint served " << metricsServer->getScrapes()
+            << " scrapes");
+    }
 
-                    WSAPOLLFD clientPollFd = {};
-                    clientPollFd.fd = clientSocket;
-                    clientPollFd.events = POLLRDNORM;
+    if (admission) {
+        LOG_INFO("[SHUTDOWN] Acceptor: " << admission->getAccepted() << " accepted, "
+            << admission->getRefused() << " refused, peak admission queue "
+            << admission->getPeakWaiting());
+        admission->closeWaiting();
+    }
+    for (const auto& reactor : reactors) {
+        const AdmissionQueue* reactorAdmission = reactor->getAdmissionQueue();
+        if (reactorAdmission) {
+            LOG_INFO("[SHUTDOWN] Reactor acceptor: " << reactorAdmission->getAccepted()
+                << " accepted, " << reactorAdmission->getRefused()
+                << " refused, peak admission queue " << reactorAdmission->getPeakWaiting());
+        }
+    }
 
-                    {
-                        lock_guard<mutex> lock(pollFdsMutex);
-                        pollFds.push_back(clientPollFd);
-                    }
+    if (listenSocket != INVALID_SOCKET) {
+        closesocket(listenSocket);
+    }
 
-                    string welcome = "WELCOME:Chat Server\n";
-                    sendToClient(clientSocket, welcome);
-                }
-            }
-            else {
-                SOCKET clientSocket = currentPollFds[i].fd;
-
-                if (currentPollFds[i].revents & (POLLRDNORM | POLLHUP | POLLERR)) {
-                    int bytesReceived = recv(clientSocket, buffer, BUFFER_SIZE - 1, 0);
-
-                    if (bytesReceived <= 0) {
-                        handleClientDisconnect(clientSocket, pollFds, pollFdsMutex);
-                    }
-                    else {
-                        buffer[bytesReceived] = '\0';
-                        handleClientMessage(clientSocket, buffer, bytesReceived);
-                    }
-                }
-            }
-        }
+    for (auto& reactor : reactors) {
+        reactor->join();
     }
+    LOG_INFO("[SHUTDOWN] Reactor threads joined");
 
-    cout << "\n[SHUTDOWN] Initiating shutdown sequence..." << endl;
+    stopBroadcasters();
+    LOG_INFO("[SHUTDOWN] Broadcaster threads joined");
 
-    closesocket(listenSocket);
-    g_messageCV.notify_all();
+    LOG_INFO("[SHUTDOWN] Flood control: " << g_serverMetrics.rateLimitedByClient.get()
+        << " messages dropped by client limits, " << g_serverMetrics.rateLimitedByRoom.get()
+        << " by room limits");
 
-    if (broadcasterThread.joinable()) {
-        broadcasterThread.join();
-        cout << "[SHUTDOWN] Broadcaster thread joined" << endl;
-    }
+    g_chatRooms.clear();
 
-    {
-        lock_guard<mutex> lock(pollFdsMutex);
-        for (size_t i = 1; i < pollFds.size(); i++) {
-            if (pollFds[i].fd != INVALID_SOCKET) {
-                closesocket(pollFds[i].fd);
-            }
-        }
-        pollFds.clear();
+    for (auto& reactor : reactors) {
+        reactor->closeAllConnections();
     }
 
-    {
-        lock_guard<mutex> lock(g_chatRoomsMutex);
-        g_chatRooms.clear();
-    }
+    g_connections.clear();
 
-    {
-        lock_guard<mutex> lock(g_clientsMutex);
-        g_clients.clear();
-    }
+    g_clients.clear();
+    g_usernames.clear();
+
+    // Connections hold raw EventLoop pointers, so reactors go last
+    reactors.clear();
 
     WSACleanup();
 
-    cout << "[SHUTDOWN] Server shutdown complete" << endl;
+    // Everything that could queue a write has stopped; commit the rest
+    g_persistence->stop();
+    LOG_INFO("[SHUTDOWN] Persistence writer: " << g_persistence->getCommittedMessages()
+        << " messages in " << g_persistence->getBatches() << " commits, largest batch "
+        << g_persistence->getLargestBatch() << ", " << g_persistence->getStalls()
+        << " stalls, " << g_persistence->getFailedMessages() << " failed");
+    g_persistence.reset();
+
+    LOG_INFO("[SHUTDOWN] Log writer: " << g_logger.getWrittenLines() << " lines written, "
+        << g_logger.getDroppedLines() << " dropped");
+    LOG_INFO("[SHUTDOWN] Server shutdown complete");
     
     // Close database (unique_ptr will handle cleanup)
     g_database.reset();
-    
+
+    g_clock.stop();
+
+    // Last: writes out whatever the threads above logged
+    g_logger.stop();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+// Per-insert cost of Database::saveMessage with cached prepared statements,
+// compared with the previous prepare/finalize-per-call implementation.
+//
+// Usage: DatabaseBench [iterations] [database path]
+// The default path is ":memory:", which isolates SQL compile cost from
+// disk I/O. With a file path, "<path>.before" and "<path>.after" are
+// created (and overwritten) next to it.
+
+#include "Database.h"
+#include <cstdio>
+
+// The pre-cache saveMessage: compiles the statement on every call
+static void saveMessageUncached(sqlite3* db, mutex& dbMutex, const string& roomId,
+    const string& sender, const string& content) {
+    lock_guard<mutex> lock(dbMutex);
+
+    sqlite3_stmt* stmt;
+    const char* sql = R"(
+        INSERT INTO messages (room_id, sender_username, content, is_private, recipient_username) 
+        VALUES (?, ?, ?, ?, ?);
+    )";
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+
+    sqlite3_bind_text(stmt, 1, roomId.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, sender.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, content.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 4, 0);
+    sqlite3_bind_null(stmt, 5);
+
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+}
+
+// Messages table as created by Database::initialize
+static const char* s_messagesSchema = R"(
+    PRAGMA journal_mode=WAL;
+    CREATE TABLE IF NOT EXISTS messages (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        room_id TEXT NOT NULL,
+        sender_username TEXT NOT NULL,
+        content TEXT NOT NULL,
+        is_private INTEGER NOT NULL DEFAULT 0,
+        recipient_username TEXT,
+        timestamp DATETIME DEFAULT CURRENT_TIMESTAMP
+    );
+    CREATE INDEX IF NOT EXISTS idx_messages_room ON messages(room_id);
+    CREATE INDEX IF NOT EXISTS idx_messages_timestamp ON messages(timestamp);
+    CREATE INDEX IF NOT EXISTS idx_messages_sender ON messages(sender_username);
+)";
+
+static string benchPath(const string& path, const char* suffix) {
+    if (path == ":memory:") {
+        return path;
+    }
+    string fullPath = path + suffix;
+    remove(fullPath.c_str());
+    remove((fullPath + "-wal").c_str());
+    remove((fullPath + "-shm").c_str());
+    return fullPath;
+}
+
+static void report(const char* label, int iterations, chrono::nanoseconds elapsed) {
+    double perInsert = static_cast<double>(elapsed.count()) / iterations;
+    cout << "  " << label << ": " << iterations << " inserts in "
+        << chrono::duration_cast<chrono::milliseconds>(elapsed).count() << " ms ("
+        << static_cast<long long>(perInsert) << " ns/insert)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = (argc > 1) ? atoi(argv[1]) : 100000;
+    string path = (argc > 2) ? argv[2] : ":memory:";
+
+    if (iterations <= 0) {
+        cout << "Usage: " << argv[0] << " [iterations] [database path]" << endl;
+        return 1;
+    }
+
+    const string roomId = "123456";
+    const string sender = "alice";
+    const string content = "The quick brown fox jumps over the lazy dog";
+
+    chrono::nanoseconds uncachedTime;
+    chrono::nanoseconds cachedTime;
+
+    // Before: prepare + finalize per insert, on a connection set up like
+    // Database's (WAL, same messages table and indexes)
+    {
+        sqlite3* db = nullptr;
+        if (sqlite3_open(benchPath(path, ".before").c_str(), &db) != SQLITE_OK) {
+            cout << "[ERROR] Cannot open database: " << sqlite3_errmsg(db) << endl;
+            return 1;
+        }
+        sqlite3_exec(db, s_messagesSchema, nullptr, nullptr, nullptr);
+
+        mutex dbMutex;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            saveMessageUncached(db, dbMutex, roomId, sender, content);
+        }
+        uncachedTime = chrono::steady_clock::now() - start;
+        sqlite3_close(db);
+    }
+
+    // After: statements prepared once in initialize()
+    {
+        Database database(benchPath(path, ".after"));
+        if (!database.initialize()) {
+            return 1;
+        }
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            database.saveMessage(roomId, sender, content);
+        }
+        cachedTime = chrono::steady_clock::now() - start;
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "  saveMessage benchmark (" << path << ")" << endl;
+    cout << "========================================" << endl;
+    report("prepare per call", iterations, uncachedTime);
+    report("cached statement", iterations, cachedTime);
+    cout << "  speedup: " << static_cast<double>(uncachedTime.count()) / cachedTime.count()
+        << "x" << endl;
+    return 0;
+}
\ No newline at end of file
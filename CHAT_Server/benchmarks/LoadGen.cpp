@@ -0,0 +1,506 @@
+// Load generator: connects a crowd of simulated users to a running server,
+// spreads them over rooms, has them chat at a fixed total rate and measures
+// how long each message takes to reach the other members of its room.
+//
+// Usage: LoadGen [--users=N] [--rooms=N] [--rate=N] [--duration=S]
+//                [--size=N] [--host=ADDR] [--port=N]
+// Defaults: 1000 users in 10 rooms sending 1000 messages/s in total for
+// 10 s, 64-byte messages, 127.0.0.1:12345.
+//
+// Every message carries its send time, so latency runs from the sender's
+// send() to each receiver's recv() and includes the broadcast fan-out.
+// The server's flood limits apply to this traffic: either keep --rate
+// within them or start the server with --client-rate=0 --client-bytes=0
+// --room-rate=0 --room-bytes=0, otherwise drops show up as RATE_LIMITED.
+// Both processes need an open-file limit above --users (ulimit -n).
+//
+// Linux only (epoll).
+
+#include "Common.h"
+#include "Protocol.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+
+namespace {
+
+enum class Stage { Connecting, Naming, Joining, Ready, Closed };
+
+struct User {
+    int fd = -1;
+    size_t room = 0;
+    Stage stage = Stage::Connecting;
+    FrameDecoder decoder;
+    string outbound;
+    bool writeInterest = false;
+};
+
+struct Room {
+    string id;
+    size_t creator = 0;
+    vector<size_t> waiting;     // Named users waiting for the room to exist
+    size_t readyMembers = 0;
+};
+
+struct Options {
+    int users = 1000;
+    int rooms = 10;
+    int rate = 1000;
+    int duration = 10;
+    int size = 64;
+    string host = "127.0.0.1";
+    int port = PORT;
+};
+
+struct Counters {
+    int refused = 0;
+    int failed = 0;
+    int disconnected = 0;
+    uint64_t rateLimited = 0;
+    uint64_t busy = 0;
+    uint64_t otherErrors = 0;
+    uint64_t delivered = 0;
+};
+
+// Parses "--name=<integer>" into value. Returns false if arg is a
+// different option.
+bool parseIntOption(const string& arg, const string& name, int& value) {
+    string prefix = "--" + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    value = atoi(arg.c_str() + prefix.size());
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (parseIntOption(arg, "users", options.users) ||
+            parseIntOption(arg, "rooms", options.rooms) ||
+            parseIntOption(arg, "rate", options.rate) ||
+            parseIntOption(arg, "duration", options.duration) ||
+            parseIntOption(arg, "size", options.size) ||
+            parseIntOption(arg, "port", options.port)) {
+            continue;
+        }
+        if (arg.compare(0, 7, "--host=") == 0) {
+            options.host = arg.substr(7);
+            continue;
+        }
+        cout << "Unknown option: " << arg << endl;
+        return false;
+    }
+
+    if (options.users < 2 || options.rooms < 1 || options.rooms > options.users ||
+        options.rate < 1 || options.duration < 1 || options.size < 32) {
+        cout << "Need users >= 2, 1 <= rooms <= users, rate >= 1, duration >= 1, "
+            << "size >= 32" << endl;
+        return false;
+    }
+    return true;
+}
+
+int64_t nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double percentile(vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1));
+    return sorted[index];
+}
+
+class LoadGenerator {
+private:
+    Options m_options;
+    int m_epollFd;
+    vector<User> m_users;
+    vector<Room> m_rooms;
+    vector<int> m_userByFd;
+    Counters m_counters;
+    vector<double> m_latenciesMs;
+    size_t m_readyUsers;
+
+    void setWriteInterest(User& user, bool enabled) {
+        if (user.writeInterest == enabled) {
+            return;
+        }
+        user.writeInterest = enabled;
+
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP | (enabled ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        event.data.fd = user.fd;
+        epoll_ctl(m_epollFd, EPOLL_CTL_MOD, user.fd, &event);
+    }
+
+    void closeUser(User& user) {
+        if (user.stage == Stage::Ready) {
+            m_rooms[user.room].readyMembers--;
+            m_readyUsers--;
+        }
+        if (user.stage != Stage::Closed) {
+            epoll_ctl(m_epollFd, EPOLL_CTL_DEL, user.fd, nullptr);
+            user.stage = Stage::Closed;
+        }
+    }
+
+    void flush(User& user) {
+        while (!user.outbound.empty()) {
+            ssize_t sent = send(user.fd, user.outbound.data(), user.outbound.size(),
+                MSG_NOSIGNAL);
+            if (sent > 0) {
+                user.outbound.erase(0, static_cast<size_t>(sent));
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                setWriteInterest(user, true);
+                return;
+            }
+            m_counters.disconnected++;
+            closeUser(user);
+            return;
+        }
+        setWriteInterest(user, false);
+    }
+
+    void sendFrame(User& user, Opcode opcode, string_view payload) {
+        encodeFrame(user.outbound, opcode, payload);
+        flush(user);
+    }
+
+    void becomeReady(User& user) {
+        user.stage = Stage::Ready;
+        m_rooms[user.room].readyMembers++;
+        m_readyUsers++;
+    }
+
+    void handleLine(size_t index, string_view line) {
+        User& user = m_users[index];
+        Room& room = m_rooms[user.room];
+
+        // Chat lines look like "[hh:mm:ss] name: LG <send time ns> ..."
+        size_t marker = line.find(": LG ");
+        if (marker != string_view::npos) {
+            int64_t sentAt = strtoll(line.data() + marker + 5, nullptr, 10);
+            m_latenciesMs.push_back((nowNanos() - sentAt) / 1e6);
+            m_counters.delivered++;
+            return;
+        }
+
+        if (line.compare(0, 8, "WELCOME:") == 0 && user.stage == Stage::Connecting) {
+            user.stage = Stage::Naming;
+            sendFrame(user, Opcode::Command, "SETNAME lg" + to_string(index));
+        }
+        else if (line.compare(0, 8, "NAME_SET") == 0 && user.stage == Stage::Naming) {
+            user.stage = Stage::Joining;
+            if (index == room.creator) {
+                sendFrame(user, Opcode::Command, "CREATE PUBLIC");
+            }
+            else if (!room.id.empty()) {
+                sendFrame(user, Opcode::Command, "JOIN " + room.id);
+            }
+            else {
+                room.waiting.push_back(index);
+            }
+        }
+        else if (line.compare(0, 13, "ROOM_CREATED:") == 0) {
+            string_view id = line.substr(13);
+            size_t end = id.find_first_of(": \r\n");
+            room.id = string(id.substr(0, end));
+            becomeReady(user);
+            for (size_t waiter : room.waiting) {
+                sendFrame(m_users[waiter], Opcode::Command, "JOIN " + room.id);
+            }
+            room.waiting.clear();
+        }
+        else if (line.compare(0, 12, "ROOM_JOINED:") == 0) {
+            becomeReady(user);
+        }
+        else if (line.compare(0, 13, "RATE_LIMITED:") == 0) {
+            m_counters.rateLimited++;
+        }
+        else if (line.compare(0, 21, "ERROR: Server is busy") == 0) {
+            m_counters.busy++;
+        }
+        else if (line.compare(0, 21, "ERROR: Server is full") == 0) {
+            m_counters.refused++;
+            closeUser(user);
+        }
+        else if (line.compare(0, 6, "ERROR:") == 0) {
+            m_counters.otherErrors++;
+        }
+    }
+
+    void readUser(size_t index) {
+        User& user = m_users[index];
+        char buffer[16384];
+
+        while (user.stage != Stage::Closed) {
+            ssize_t received = recv(user.fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                user.decoder.feed(buffer, static_cast<size_t>(received));
+
+                Frame frame;
+                while (user.stage != Stage::Closed && user.decoder.next(frame)) {
+                    handleLine(index, frame.payload);
+                }
+                if (user.decoder.hasError()) {
+                    m_counters.failed++;
+                    closeUser(user);
+                }
+                continue;
+            }
+
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;
+            }
+            m_counters.disconnected++;
+            closeUser(user);
+        }
+    }
+
+    void poll(int timeoutMs) {
+        epoll_event events[1024];
+        int ready = epoll_wait(m_epollFd, events, 1024, timeoutMs);
+
+        for (int i = 0; i < ready; i++) {
+            int userIndex = m_userByFd[events[i].data.fd];
+            if (userIndex < 0) {
+                continue;
+            }
+            User& user = m_users[userIndex];
+
+            if (events[i].events & EPOLLOUT) {
+                flush(user);
+            }
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) {
+                readUser(static_cast<size_t>(userIndex));
+            }
+        }
+    }
+
+public:
+    explicit LoadGenerator(const Options& options)
+        : m_options(options)
+        , m_epollFd(epoll_create1(0))
+        , m_users(options.users)
+        , m_rooms(options.rooms)
+        , m_readyUsers(0) {
+        for (size_t i = 0; i < m_users.size(); i++) {
+            m_users[i].room = i % m_rooms.size();
+        }
+        for (size_t r = 0; r < m_rooms.size(); r++) {
+            m_rooms[r].creator = r;
+        }
+    }
+
+    ~LoadGenerator() {
+        for (const User& user : m_users) {
+            if (user.fd >= 0) {
+                close(user.fd);
+            }
+        }
+        close(m_epollFd);
+    }
+
+    // Connects every user, names it and puts it in its room. Returns false
+    // if the address is bad.
+    bool setUp(double& setupMs) {
+        sockaddr_in serverAddr = {};
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_port = htons(static_cast<uint16_t>(m_options.port));
+        if (inet_pton(AF_INET, m_options.host.c_str(), &serverAddr.sin_addr) != 1) {
+            cout << "[ERROR] Invalid address: " << m_options.host << endl;
+            return false;
+        }
+
+        auto start = chrono::steady_clock::now();
+
+        for (User& user : m_users) {
+            int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            if (fd < 0 ||
+                (connect(fd, reinterpret_cast<sockaddr*>(&serverAddr), sizeof(serverAddr)) != 0 &&
+                    errno != EINPROGRESS)) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+                user.stage = Stage::Closed;
+                m_counters.failed++;
+                continue;
+            }
+
+            user.fd = fd;
+            if (static_cast<size_t>(fd) >= m_userByFd.size()) {
+                m_userByFd.resize(fd + 1024, -1);
+            }
+            m_userByFd[fd] = static_cast<int>(&user - m_users.data());
+
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.fd = fd;
+            epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+
+        auto deadline = start + chrono::seconds(60);
+        while (chrono::steady_clock::now() < deadline) {
+            size_t settled = 0;
+            for (const User& user : m_users) {
+                if (user.stage == Stage::Ready || user.stage == Stage::Closed) {
+                    settled++;
+                }
+            }
+            if (settled == m_users.size()) {
+                break;
+            }
+            poll(100);
+        }
+
+        setupMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    // Sends --rate messages per second, round-robin over ready users, for
+    // --duration seconds, then waits for stragglers. Returns messages sent
+    // and the number of deliveries they should produce.
+    void run(uint64_t& sent, uint64_t& expected, double& runMs) {
+        vector<size_t> senders;
+        for (size_t i = 0; i < m_users.size(); i++) {
+            if (m_users[i].stage == Stage::Ready && m_rooms[m_users[i].room].readyMembers > 1) {
+                senders.push_back(i);
+            }
+        }
+
+        sent = 0;
+        expected = 0;
+        if (senders.empty()) {
+            runMs = 0.0;
+            return;
+        }
+
+        string padding(static_cast<size_t>(m_options.size), 'x');
+        size_t nextSender = 0;
+        auto start = chrono::steady_clock::now();
+        auto sendEnd = start + chrono::seconds(m_options.duration);
+
+        while (true) {
+            auto now = chrono::steady_clock::now();
+            if (now >= sendEnd) {
+                break;
+            }
+
+            double elapsed = chrono::duration<double>(now - start).count();
+            uint64_t due = static_cast<uint64_t>(elapsed * m_options.rate);
+
+            size_t skipped = 0;
+            while (sent < due && skipped < senders.size()) {
+                User& user = m_users[senders[nextSender]];
+                nextSender = (nextSender + 1) % senders.size();
+                if (user.stage != Stage::Ready) {
+                    skipped++;
+                    continue;
+                }
+                skipped = 0;
+
+                string text = "LG " + to_string(nowNanos()) + " ";
+                if (text.size() < padding.size()) {
+                    text.append(padding, 0, padding.size() - text.size());
+                }
+                expected += m_rooms[user.room].readyMembers - 1;
+                sent++;
+                sendFrame(user, Opcode::Chat, text);
+            }
+
+            poll(1);
+        }
+
+        // Drain: stop once everything arrived or nothing has for a while
+        auto lastProgress = chrono::steady_clock::now();
+        uint64_t lastDelivered = m_counters.delivered;
+        while (m_counters.delivered < expected &&
+            chrono::steady_clock::now() - lastProgress < chrono::seconds(2)) {
+            poll(10);
+            if (m_counters.delivered != lastDelivered) {
+                lastDelivered = m_counters.delivered;
+                lastProgress = chrono::steady_clock::now();
+            }
+        }
+
+        runMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+    void report(double setupMs, uint64_t sent, uint64_t expected, double runMs) {
+        sort(m_latenciesMs.begin(), m_latenciesMs.end());
+
+        cout << "Users ready:            " << m_readyUsers << " / " << m_users.size()
+            << " in " << m_rooms.size() << " rooms" << endl;
+        cout << "Refused (server full):  " << m_counters.refused << endl;
+        cout << "Failed / disconnected:  " << m_counters.failed << " / "
+            << m_counters.disconnected << endl;
+        cout << "Setup time:             " << setupMs << " ms" << endl;
+        cout << "Messages sent:          " << sent << " (" << m_options.rate
+            << "/s target for " << m_options.duration << " s)" << endl;
+        cout << "Deliveries:             " << m_counters.delivered << " / " << expected
+            << " expected" << endl;
+        if (runMs > 0.0) {
+            cout << "Delivered messages/s:   "
+                << static_cast<uint64_t>(m_counters.delivered * 1000.0 / runMs) << endl;
+        }
+        cout << "RATE_LIMITED notices:   " << m_counters.rateLimited << endl;
+        cout << "Server busy drops:      " << m_counters.busy << endl;
+        cout << "Other errors:           " << m_counters.otherErrors << endl;
+        cout << "Latency p50:            " << percentile(m_latenciesMs, 0.50) << " ms" << endl;
+        cout << "Latency p99:            " << percentile(m_latenciesMs, 0.99) << " ms" << endl;
+        cout << "Latency p999:           " << percentile(m_latenciesMs, 0.999) << " ms" << endl;
+        cout << "Latency max:            " << percentile(m_latenciesMs, 1.0) << " ms" << endl;
+    }
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    rlimit limit = {};
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if (static_cast<rlim_t>(options.users) + 16 > limit.rlim_cur) {
+        cout << "[WARN] Open-file limit " << limit.rlim_cur << " is too low for "
+            << options.users << " users" << endl;
+    }
+
+    cout << "Connecting " << options.users << " users in " << options.rooms
+        << " rooms to " << options.host << ":" << options.port << "..." << endl;
+
+    LoadGenerator generator(options);
+    double setupMs = 0.0;
+    if (!generator.setUp(setupMs)) {
+        return 1;
+    }
+
+    cout << "Sending " << options.rate << " messages/s for " << options.duration
+        << " s..." << endl;
+    uint64_t sent = 0, expected = 0;
+    double runMs = 0.0;
+    generator.run(sent, expected, runMs);
+    generator.report(setupMs, sent, expected, runMs);
+    return 0;
+}
+
+#else
+
+int main() {
+    cout << "LoadGen needs epoll and only runs on Linux" << endl;
+    return 1;
+}
+
+#endif
\ No newline at end of file
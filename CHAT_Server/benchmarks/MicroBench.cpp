@@ -0,0 +1,513 @@
+// Microbenchmarks for the functions that dominate server profiles:
+// ChatRoom::broadcast, ChatRoom::addMessageToHistory, handleClientCommand,
+// getCurrentTimestamp, Database::saveMessage and Database::getMessageHistory,
+// plus the command parse on its own (tokenize, look up, take parameters) for
+// every command, next to the stringstream parse it replaced, ChatRoom
+// membership in a 10000-member room next to the set<SOCKET> it replaced,
+// and CREATE issued from several threads at once.
+//
+// Usage: MicroBench [filter] [repetitions]
+// Runs every benchmark whose name contains filter (default: all), each
+// repeated 5 times, and prints the median, fastest and slowest ns/op.
+//
+// Everything runs in-process: rooms and clients are set up in the global
+// registries with fake socket numbers, their Connections belong to an
+// EventLoop that never does I/O, and the database is an in-memory SQLite.
+// The coarse clock's ticker runs as it does in the server. Queued output
+// is discarded between timed batches so no connection ever
+// reaches MAX_OUTBOUND_BYTES. Server logging stays on at the default level
+// with its background writer, as in production, but the writer goes to a
+// null stream.
+
+#include "Common.h"
+#include "Globals.h"
+#include "Server.h"
+#include "ChatRoom.h"
+#include "Database.h"
+#include "Utilities.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "Clock.h"
+#include "Config.h"
+#include "CommandTable.h"
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+// Members of the benchmark room, and how many rooms LIST has to walk
+const size_t ROOM_MEMBERS = 100;
+const size_t ROOM_COUNT = 10;
+const SOCKET FIRST_FAKE_SOCKET = 100000;
+
+// The large room is only used for membership benchmarks; its sockets have
+// no clients or connections behind them. It is built with churn, so some
+// slots have been freed and reused, as in a long-lived room.
+const size_t LARGE_ROOM_MEMBERS = 10000;
+const size_t LARGE_ROOM_CHURN = 1000;
+const SOCKET FIRST_LARGE_ROOM_SOCKET = 200000;
+
+// Clients that run CREATE side by side, one per thread, as the reactors
+// do. Each has its own socket, name and connection but starts in no room.
+const size_t CREATE_THREADS = 4;
+const SOCKET FIRST_CREATOR_SOCKET = 300000;
+const string ROOM_ID = "100000";
+const string CHAT_LINE = "[12:34:56] member0: The quick brown fox jumps over the lazy dog\n";
+
+// One typical line per command, as it arrives in a frame payload
+const string_view COMMAND_LINES[] = {
+    "CREATE PRIVATE correct horse battery",
+    "JOIN 123456 correct horse battery",
+    "SETNAME member0",
+    "LIST",
+    "GETPASSWORD",
+    "USERS",
+    "KICK member1",
+    "BAN member1",
+    "TRANSFER member1",
+    "LEAVE",
+    "FORCELEAVE",
+    "CHANGEPASSWORD correct horse battery",
+    "HISTORY 4096 50",
+    "NOSUCHCOMMAND with some arguments"
+};
+
+// Accepts registrations and flush requests but never touches a socket
+class NullEventLoop : public EventLoop {
+public:
+    bool addSocket(SOCKET) override { return true; }
+    void removeSocket(SOCKET) override {}
+    void setWriteInterest(SOCKET, bool) override {}
+    int wait(vector<IoEvent>& events, int) override {
+        events.clear();
+        return 0;
+    }
+    void wakeup() override {}
+    const char* getBackendName() const override { return "null"; }
+};
+
+// Swallows the server's log output
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+struct Benchmark {
+    string name;
+    size_t batchSize;               // Operations per timed batch
+    function<void(size_t)> run;     // Runs that many operations
+};
+
+NullEventLoop s_eventLoop;
+vector<SOCKET> s_sockets;
+vector<SOCKET> s_creatorSockets;
+SymbolRef s_roomId;
+
+// Results are stored here so the compiler can't discard the work
+volatile size_t s_sink;
+
+// Replaces every fake client's Connection with an empty one, in the
+// registry and in the room's member slots, dropping whatever the previous
+// batch queued
+void resetConnections() {
+    shared_ptr<ChatRoom> room = findRoom(s_roomId);
+    for (SOCKET socket : s_sockets) {
+        auto connection = make_shared<Connection>(socket, &s_eventLoop);
+        g_connections.insert(socket, connection);
+
+        ClientInfo client;
+        g_clients.get(socket, client);
+        room->addClient(socket, client.getUsername(), connection);
+    }
+
+    for (SOCKET socket : s_creatorSockets) {
+        g_connections.insert(socket, make_shared<Connection>(socket, &s_eventLoop));
+    }
+
+    vector<SOCKET> flushRequests;
+    s_eventLoop.takeFlushRequests(flushRequests);
+}
+
+// One room with ROOM_MEMBERS named clients, plus empty rooms for LIST
+void setUpRooms() {
+    s_roomId = g_symbols.intern(ROOM_ID);
+    auto room = make_shared<ChatRoom>(s_roomId, false, "", FIRST_FAKE_SOCKET);
+    g_chatRooms.insert(s_roomId, room);
+
+    for (size_t i = 0; i < ROOM_MEMBERS; i++) {
+        SOCKET socket = FIRST_FAKE_SOCKET + static_cast<SOCKET>(i);
+        SymbolRef username = g_symbols.intern("member" + to_string(i));
+
+        ClientInfo client(socket);
+        client.setUsername(username);
+        client.setRoomId(s_roomId);
+        client.setIsRoomOwner(i == 0);
+        g_clients.insert(socket, client);
+        g_usernames.insert(username, socket);
+        room->addClient(socket, username, nullptr);
+        s_sockets.push_back(socket);
+    }
+
+    for (size_t i = 1; i < ROOM_COUNT; i++) {
+        SymbolRef roomId = g_symbols.intern(to_string(200000 + i));
+        g_chatRooms.insert(roomId, make_shared<ChatRoom>(roomId, false, "", INVALID_SOCKET));
+    }
+
+    for (size_t i = 0; i < CREATE_THREADS; i++) {
+        SOCKET socket = FIRST_CREATOR_SOCKET + static_cast<SOCKET>(i);
+        SymbolRef username = g_symbols.intern("creator" + to_string(i));
+
+        ClientInfo client(socket);
+        client.setUsername(username);
+        g_clients.insert(socket, client);
+        g_usernames.insert(username, socket);
+        s_creatorSockets.push_back(socket);
+    }
+
+    resetConnections();
+}
+
+// Fills room with LARGE_ROOM_MEMBERS members, and previousMembers with the
+// same sockets as the old set<SOCKET> membership, joining and leaving in
+// the same random order
+void setUpLargeRoom(ChatRoom& room, set<SOCKET>& previousMembers) {
+    vector<SOCKET> sockets;
+    for (size_t i = 0; i < LARGE_ROOM_MEMBERS + LARGE_ROOM_CHURN; i++) {
+        sockets.push_back(FIRST_LARGE_ROOM_SOCKET + static_cast<SOCKET>(i));
+    }
+
+    mt19937 random(42);
+    shuffle(sockets.begin(), sockets.end(), random);
+    for (SOCKET socket : sockets) {
+        room.addClient(socket, SymbolRef(), make_shared<Connection>(socket, &s_eventLoop));
+        previousMembers.insert(socket);
+    }
+
+    shuffle(sockets.begin(), sockets.end(), random);
+    for (size_t i = 0; i < LARGE_ROOM_CHURN; i++) {
+        room.removeClient(sockets[i]);
+        previousMembers.erase(sockets[i]);
+    }
+}
+
+// Times one benchmark: batches until at least minTime has been spent in
+// run(), with the untimed reset in between. Returns ns per operation.
+double measure(const Benchmark& benchmark, chrono::nanoseconds minTime) {
+    chrono::nanoseconds timed(0);
+    size_t operations = 0;
+
+    while (timed < minTime) {
+        resetConnections();
+        auto start = chrono::steady_clock::now();
+        benchmark.run(benchmark.batchSize);
+        timed += chrono::steady_clock::now() - start;
+        operations += benchmark.batchSize;
+    }
+
+    return static_cast<double>(timed.count()) / operations;
+}
+
+vector<Benchmark> makeBenchmarks(Database& database) {
+    shared_ptr<ChatRoom> room = findRoom(s_roomId);
+    SharedPayload payload = makeServerTextPayload(CHAT_LINE);
+    SOCKET owner = FIRST_FAKE_SOCKET;
+    vector<Benchmark> benchmarks;
+
+    benchmarks.push_back({ "ChatRoom::broadcast/" + to_string(ROOM_MEMBERS) + " members", 1000,
+        [room, payload, owner](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                room->broadcast(payload, owner);
+            }
+        } });
+
+    // Shared with the lambdas below; freed when the benchmarks are cleared
+    auto largeRoom = make_shared<ChatRoom>(g_symbols.intern("large"), false, "", INVALID_SOCKET);
+    auto previousMembers = make_shared<set<SOCKET>>();
+    auto previousJoinTimes = make_shared<map<SOCKET, chrono::steady_clock::time_point>>();
+    setUpLargeRoom(*largeRoom, *previousMembers);
+    for (SOCKET socket : *previousMembers) {
+        (*previousJoinTimes)[socket] = chrono::steady_clock::now();
+    }
+    string large = to_string(LARGE_ROOM_MEMBERS / 1000) + "k members";
+
+    benchmarks.push_back({ "ChatRoom::getRecipients/" + large, 100,
+        [largeRoom](size_t count) {
+            size_t total = 0;
+            for (size_t i = 0; i < count; i++) {
+                vector<shared_ptr<Connection>> recipients;
+                largeRoom->getRecipients(INVALID_SOCKET, recipients);
+                total += recipients.size();
+            }
+            s_sink = total;
+        } });
+
+    // How broadcast collected recipients before the flat member arrays
+    benchmarks.push_back({ "set<SOCKET> recipients/" + large + " (prev)", 100,
+        [previousMembers](size_t count) {
+            size_t total = 0;
+            for (size_t i = 0; i < count; i++) {
+                vector<SOCKET> recipients;
+                recipients.reserve(previousMembers->size());
+                for (SOCKET clientSocket : *previousMembers) {
+                    if (clientSocket != INVALID_SOCKET) {
+                        recipients.push_back(clientSocket);
+                    }
+                }
+                total += recipients.size();
+            }
+            s_sink = total;
+        } });
+
+    benchmarks.push_back({ "ChatRoom::getLongestMember/" + large, 10000,
+        [largeRoom](size_t count) {
+            size_t total = 0;
+            for (size_t i = 0; i < count; i++) {
+                total += static_cast<size_t>(largeRoom->getLongestMember());
+            }
+            s_sink = total;
+        } });
+
+    benchmarks.push_back({ "map longest member/" + large + " (prev)", 100,
+        [previousMembers, previousJoinTimes](size_t count) {
+            size_t total = 0;
+            for (size_t i = 0; i < count; i++) {
+                SOCKET longestMember = INVALID_SOCKET;
+                chrono::steady_clock::time_point earliestTime = chrono::steady_clock::now();
+                for (SOCKET sock : *previousMembers) {
+                    auto it = previousJoinTimes->find(sock);
+                    if (it != previousJoinTimes->end() &&
+                        (longestMember == INVALID_SOCKET || it->second < earliestTime)) {
+                        earliestTime = it->second;
+                        longestMember = sock;
+                    }
+                }
+                total += static_cast<size_t>(longestMember);
+            }
+            s_sink = total;
+        } });
+
+    // Membership changes only; the [ROOM] lines are muted for the batch
+    benchmarks.push_back({ "ChatRoom join+leave/" + large, 10000,
+        [largeRoom](size_t count) {
+            SOCKET socket = FIRST_LARGE_ROOM_SOCKET - 1;
+            SymbolRef name = g_symbols.intern("visitor");
+            auto connection = make_shared<Connection>(socket, &s_eventLoop);
+            g_logger.setLevel(LogLevel::Warn);
+            for (size_t i = 0; i < count; i++) {
+                largeRoom->addClient(socket, name, connection);
+                largeRoom->removeClient(socket);
+            }
+            g_logger.setLevel(LogLevel::Info);
+        } });
+
+    benchmarks.push_back({ "ChatRoom::addMessageToHistory", 10000,
+        [room, payload](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                room->addMessageToHistory(payload);
+            }
+        } });
+
+    benchmarks.push_back({ "handleClientCommand/USERS", 500,
+        [owner](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                handleClientCommand(owner, "USERS");
+            }
+        } });
+
+    benchmarks.push_back({ "handleClientCommand/LIST", 500,
+        [owner](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                handleClientCommand(owner, "LIST");
+            }
+        } });
+
+    benchmarks.push_back({ "handleClientCommand/unknown", 1000,
+        [owner](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                handleClientCommand(owner, "NOSUCHCOMMAND with some arguments");
+            }
+        } });
+
+    // Room IDs are drawn on every reactor thread at once; run under
+    // -fsanitize=thread this catches any state the CREATE path shares
+    // without a lock. Each CREATE after a creator's first also leaves its
+    // previous room to the usual delayed cleanup.
+    benchmarks.push_back({ "handleClientCommand/CREATE x" + to_string(CREATE_THREADS) + " threads",
+        CREATE_THREADS * 100,
+        [](size_t count) {
+            vector<thread> threads;
+            for (SOCKET creator : s_creatorSockets) {
+                threads.emplace_back([creator, count] {
+                    for (size_t i = 0; i < count / CREATE_THREADS; i++) {
+                        handleClientCommand(creator, "CREATE");
+                    }
+                    });
+            }
+            for (thread& worker : threads) {
+                worker.join();
+            }
+        } });
+
+    for (string_view line : COMMAND_LINES) {
+        benchmarks.push_back({ "parseCommand/" + string(line.substr(0, line.find(' '))), 10000,
+            [line](size_t count) {
+                size_t total = 0;
+                for (size_t i = 0; i < count; i++) {
+                    CommandTokenizer tokens(line);
+                    CommandId id = findCommand(tokens.next());
+                    total += static_cast<size_t>(id) + tokens.rest().size();
+                }
+                s_sink = total;
+            } });
+    }
+
+    // The parse handleClientCommand did before the command table, for scale
+    benchmarks.push_back({ "parseCommand/stringstream (previous)", 10000,
+        [](size_t count) {
+            static const string names[] = { "CREATE", "JOIN", "SETNAME", "LIST", "GETPASSWORD",
+                "USERS", "KICK", "BAN", "TRANSFER", "LEAVE", "FORCELEAVE", "CHANGEPASSWORD" };
+            const string line(COMMAND_LINES[static_cast<size_t>(CommandId::History)]);
+            size_t total = 0;
+            for (size_t i = 0; i < count; i++) {
+                stringstream ss(line);
+                string cmd, params;
+                ss >> cmd;
+                for (const string& name : names) {
+                    total += (cmd == name);
+                }
+                getline(ss, params);
+                total += trim(params).size();
+            }
+            s_sink = total;
+        } });
+
+    benchmarks.push_back({ "getCurrentTimestamp", 10000,
+        [](size_t count) {
+            size_t length = 0;
+            for (size_t i = 0; i < count; i++) {
+                length += getCurrentTimestamp().size();
+            }
+            s_sink = length;
+        } });
+
+    benchmarks.push_back({ "getCurrentTimestamp/epoch-ms", 10000,
+        [](size_t count) {
+            size_t length = 0;
+            g_config.timestampMode = TimestampMode::EpochMillis;
+            for (size_t i = 0; i < count; i++) {
+                length += getCurrentTimestamp().size();
+            }
+            g_config.timestampMode = TimestampMode::Local;
+            s_sink = length;
+        } });
+
+    benchmarks.push_back({ "LOG_DEBUG/below level", 10000,
+        [](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                LOG_DEBUG("[BROADCAST] Room " << ROOM_ID << " - " << CHAT_LINE);
+            }
+        } });
+
+    benchmarks.push_back({ "LOG_INFO", 1000,
+        [owner](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                LOG_INFO("[CMD] Client " << owner << " joined room: " << ROOM_ID);
+            }
+        } });
+
+    benchmarks.push_back({ "Database::saveMessage", 1000,
+        [&database](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                database.saveMessage("300000", "member0",
+                    "The quick brown fox jumps over the lazy dog");
+            }
+        } });
+
+    benchmarks.push_back({ "Database::getMessageHistory/" + to_string(MAX_MESSAGE_HISTORY) + " rows",
+        100,
+        [&database](size_t count) {
+            size_t rows = 0;
+            for (size_t i = 0; i < count; i++) {
+                rows += database.getMessageHistory(ROOM_ID).size();
+            }
+            s_sink = rows;
+        } });
+
+    return benchmarks;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    string filter = argc > 1 ? argv[1] : "";
+    int repetitions = argc > 2 ? atoi(argv[2]) : 5;
+    if (repetitions <= 0) {
+        cout << "Usage: " << argv[0] << " [filter] [repetitions]" << endl;
+        return 1;
+    }
+
+    NullBuffer nullBuffer;
+    ostream nullStream(&nullBuffer);
+    g_logger.start(nullStream);
+    g_clock.start();
+    streambuf* consoleBuffer = cout.rdbuf(&nullBuffer);
+
+    auto database = make_unique<Database>(":memory:", 0);
+    if (!database->initialize()) {
+        cout.rdbuf(consoleBuffer);
+        cout << "[ERROR] Cannot open in-memory database" << endl;
+        return 1;
+    }
+
+    // A room with more stored messages than one history read returns
+    for (int i = 0; i < 10 * MAX_MESSAGE_HISTORY; i++) {
+        database->saveMessage(ROOM_ID, "member" + to_string(i % ROOM_MEMBERS),
+            "Stored message number " + to_string(i));
+    }
+
+    setUpRooms();
+    vector<Benchmark> benchmarks = makeBenchmarks(*database);
+
+    cout.rdbuf(consoleBuffer);
+    cout << left << setw(44) << "Benchmark" << right << setw(12) << "median ns/op"
+        << setw(10) << "min" << setw(10) << "max" << endl;
+    cout << string(76, '-') << endl;
+
+    for (const Benchmark& benchmark : benchmarks) {
+        if (benchmark.name.find(filter) == string::npos) {
+            continue;
+        }
+
+        cout.rdbuf(&nullBuffer);
+        measure(benchmark, chrono::milliseconds(20));     // Warm-up
+
+        vector<double> results;
+        for (int i = 0; i < repetitions; i++) {
+            results.push_back(measure(benchmark, chrono::milliseconds(200)));
+        }
+        sort(results.begin(), results.end());
+        cout.rdbuf(consoleBuffer);
+
+        cout << left << setw(44) << benchmark.name << right << fixed << setprecision(1)
+            << setw(12) << results[results.size() / 2] << setw(10) << results.front()
+            << setw(10) << results.back() << endl;
+    }
+
+    // Tear down while the log is still muted, once the room cleanups that
+    // CREATE left behind have run
+    cout.rdbuf(&nullBuffer);
+    this_thread::sleep_for(chrono::milliseconds(200));
+    benchmarks.clear();
+    g_chatRooms.clear();
+    g_clients.clear();
+    g_usernames.clear();
+    s_roomId = SymbolRef();
+    g_connections.clear();
+    database.reset();
+    g_clock.stop();
+    g_logger.stop();
+    cout.rdbuf(consoleBuffer);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+// Reconnect storm: opens N connections to a running server at once, as
+// every client does after a restart, and measures how long it takes until
+// each one has received WELCOME.
+//
+// Usage: ReconnectBench [connections] [host] [port]
+// Defaults: 20000 connections to 127.0.0.1:12345. Start the server first,
+// e.g. with --accept-rate / --max-connections to compare admission
+// settings. Both processes need an open-file limit above N (ulimit -n).
+//
+// Linux only (epoll).
+
+#include "Common.h"
+#include "Protocol.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+
+namespace {
+
+struct ClientState {
+    bool active = false;
+    chrono::steady_clock::time_point started;
+    FrameDecoder decoder;
+};
+
+enum class Outcome { Pending, Welcomed, Refused, Failed };
+
+// Reads what the server sent and classifies the connection
+Outcome readReply(int fd, ClientState& state) {
+    char buffer[4096];
+
+    while (true) {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            state.decoder.feed(buffer, static_cast<size_t>(received));
+
+            Frame frame;
+            while (state.decoder.next(frame)) {
+                if (frame.payload.compare(0, 8, "WELCOME:") == 0) {
+                    return Outcome::Welcomed;
+                }
+                if (frame.payload.compare(0, 6, "ERROR:") == 0) {
+                    return Outcome::Refused;
+                }
+            }
+            if (state.decoder.hasError()) {
+                return Outcome::Failed;
+            }
+            continue;
+        }
+
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return Outcome::Pending;
+        }
+        return Outcome::Failed;
+    }
+}
+
+double percentile(vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1));
+    return sorted[index];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int connections = argc > 1 ? atoi(argv[1]) : 20000;
+    string host = argc > 2 ? argv[2] : "127.0.0.1";
+    int port = argc > 3 ? atoi(argv[3]) : PORT;
+
+    rlimit limit = {};
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if (static_cast<rlim_t>(connections) + 16 > limit.rlim_cur) {
+        cout << "[WARN] Open-file limit " << limit.rlim_cur << " is too low for "
+            << connections << " connections" << endl;
+    }
+
+    sockaddr_in serverAddr = {};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &serverAddr.sin_addr) != 1) {
+        cout << "[ERROR] Invalid address: " << host << endl;
+        return 1;
+    }
+
+    int epollFd = epoll_create1(0);
+    vector<ClientState> clients(limit.rlim_cur);
+    vector<int> sockets;
+    vector<double> latenciesMs;
+    int pending = 0, welcomed = 0, refused = 0, failed = 0;
+
+    cout << "Opening " << connections << " connections to " << host << ":" << port
+        << "..." << endl;
+    auto start = chrono::steady_clock::now();
+    auto lastWelcome = start;
+
+    // Fire every connect before reading anything, like a storm of clients
+    for (int i = 0; i < connections; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (fd < 0) {
+            failed++;
+            continue;
+        }
+
+        if (connect(fd, reinterpret_cast<sockaddr*>(&serverAddr), sizeof(serverAddr)) != 0 &&
+            errno != EINPROGRESS) {
+            close(fd);
+            failed++;
+            continue;
+        }
+
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+
+        clients[fd].active = true;
+        clients[fd].started = chrono::steady_clock::now();
+        sockets.push_back(fd);
+        pending++;
+    }
+
+    auto connectDone = chrono::steady_clock::now();
+    auto deadline = connectDone + chrono::seconds(60);
+    vector<epoll_event> events(1024);
+
+    while (pending > 0 && chrono::steady_clock::now() < deadline) {
+        int ready = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), 100);
+
+        for (int i = 0; i < ready; i++) {
+            int fd = events[i].data.fd;
+            ClientState& state = clients[fd];
+            if (!state.active) {
+                continue;
+            }
+
+            Outcome outcome = readReply(fd, state);
+            if (outcome == Outcome::Pending) {
+                continue;
+            }
+
+            auto now = chrono::steady_clock::now();
+            state.active = false;
+            pending--;
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+
+            if (outcome == Outcome::Welcomed) {
+                welcomed++;
+                lastWelcome = now;
+                latenciesMs.push_back(
+                    chrono::duration<double, milli>(now - state.started).count());
+            }
+            else if (outcome == Outcome::Refused) {
+                refused++;
+            }
+            else {
+                failed++;
+            }
+        }
+    }
+
+    sort(latenciesMs.begin(), latenciesMs.end());
+    double connectMs = chrono::duration<double, milli>(connectDone - start).count();
+    double allConnectedMs = chrono::duration<double, milli>(lastWelcome - start).count();
+
+    cout << "Issued connects in:     " << connectMs << " ms" << endl;
+    cout << "Welcomed:               " << welcomed << " / " << connections << endl;
+    cout << "Refused (server full):  " << refused << endl;
+    cout << "Failed:                 " << failed << endl;
+    cout << "Timed out:              " << pending << endl;
+    cout << "Time to all connected:  " << allConnectedMs << " ms" << endl;
+    if (allConnectedMs > 0.0) {
+        cout << "Admission rate:         " << static_cast<int>(welcomed * 1000.0 / allConnectedMs)
+            << " connections/s" << endl;
+    }
+    cout << "WELCOME latency p50:    " << percentile(latenciesMs, 0.50) << " ms" << endl;
+    cout << "WELCOME latency p99:    " << percentile(latenciesMs, 0.99) << " ms" << endl;
+    cout << "WELCOME latency max:    " << percentile(latenciesMs, 1.0) << " ms" << endl;
+
+    for (int fd : sockets) {
+        close(fd);
+    }
+    close(epollFd);
+    return pending == 0 ? 0 : 1;
+}
+
+#else
+
+int main() {
+    cout << "ReconnectBench needs epoll and only runs on Linux" << endl;
+    return 1;
+}
+
+#endif
\ No newline at end of file
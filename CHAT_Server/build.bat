@@ -15,17 +15,34 @@ if %errorlevel% neq 0 (
     exit /b 1
 )
 
-echo.
-echo [2/2] Building Chat Server...
-cl /EHsc /MD /Fe:ChatServer.exe ^
-   main.cpp ^
-   Server.cpp ^
+rem Everything but main.cpp; the microbenchmarks link the same sources
+set SERVER_SOURCES=Server.cpp ^
    ClientInfo.cpp ^
    ChatRoom.cpp ^
    Message.cpp ^
    Utilities.cpp ^
    Globals.cpp ^
    Database.cpp ^
+   EventLoop.cpp ^
+   Protocol.cpp ^
+   Connection.cpp ^
+   Config.cpp ^
+   MessageShard.cpp ^
+   Reactor.cpp ^
+   LockOrder.cpp ^
+   PersistenceWriter.cpp ^
+   AdmissionQueue.cpp ^
+   Metrics.cpp ^
+   MetricsServer.cpp ^
+   Logger.cpp ^
+   Clock.cpp ^
+   SymbolTable.cpp
+
+echo.
+echo [2/2] Building Chat Server...
+cl /EHsc /MD /std:c++17 /Fe:ChatServer.exe ^
+   main.cpp ^
+   %SERVER_SOURCES% ^
    sqlite3.obj ^
    ws2_32.lib
 
@@ -35,6 +52,42 @@ if %errorlevel% neq 0 (
     exit /b 1
 )
 
+rem "build.bat bench" also builds the benchmarks into ..\benchmarks;
+rem "build.bat microbench [filter]" builds them and runs the microbenchmarks
+set BUILD_BENCH=
+if /i "%1"=="bench" set BUILD_BENCH=1
+if /i "%1"=="microbench" set BUILD_BENCH=1
+if defined BUILD_BENCH (
+    echo.
+    echo [bench] Building benchmarks...
+    cl /EHsc /MD /O2 /DNDEBUG /std:c++17 /I. /Fe:..\benchmarks\DatabaseBench.exe ^
+       ..\benchmarks\DatabaseBench.cpp ^
+       Database.cpp ^
+       Logger.cpp ^
+       sqlite3.obj
+    if errorlevel 1 (
+        echo ERROR: Benchmark compilation failed!
+        pause
+        exit /b 1
+    )
+    cl /EHsc /MD /O2 /DNDEBUG /std:c++17 /I. /Fe:..\benchmarks\MicroBench.exe ^
+       ..\benchmarks\MicroBench.cpp ^
+       %SERVER_SOURCES% ^
+       sqlite3.obj ^
+       ws2_32.lib
+    if errorlevel 1 (
+        echo ERROR: Benchmark compilation failed!
+        pause
+        exit /b 1
+    )
+)
+
+if /i "%1"=="microbench" (
+    echo.
+    echo [microbench] Running hot-path microbenchmarks...
+    ..\benchmarks\MicroBench.exe %2
+)
+
 echo.
 echo ========================================
 echo BUILD SUCCESSFUL!
@@ -0,0 +1,66 @@
+#!/bin/sh
+# Linux build for the chat server (see build.bat for the Windows equivalent).
+# Requires g++ and the SQLite development package (libsqlite3-dev).
+set -e
+
+echo "========================================"
+echo "Building Chat Server (Linux)"
+echo "========================================"
+
+cd "$(dirname "$0")/CHAT_APPLICATION_SERVER"
+
+# Everything but main.cpp; the microbenchmarks link the same objects
+SERVER_SOURCES="Server.cpp
+    ClientInfo.cpp
+    ChatRoom.cpp
+    Message.cpp
+    Utilities.cpp
+    Globals.cpp
+    Database.cpp
+    EventLoop.cpp
+    Protocol.cpp
+    Connection.cpp
+    Config.cpp
+    MessageShard.cpp
+    Reactor.cpp
+    LockOrder.cpp
+    PersistenceWriter.cpp
+    AdmissionQueue.cpp
+    Metrics.cpp
+    MetricsServer.cpp
+    Logger.cpp
+    Clock.cpp
+    SymbolTable.cpp"
+
+CXXFLAGS="${CXXFLAGS:--O2 -DNDEBUG}"
+
+echo
+echo "[1/1] Building Chat Server..."
+g++ -std=c++17 $CXXFLAGS -pthread -o ChatServer main.cpp $SERVER_SOURCES -lsqlite3
+
+# "./build.sh bench" also builds the benchmarks into ../benchmarks
+if [ "$1" = "bench" ] || [ "$1" = "microbench" ]; then
+    echo
+    echo "[bench] Building benchmarks..."
+    g++ -std=c++17 $CXXFLAGS -pthread -I. -o ../benchmarks/DatabaseBench \
+        ../benchmarks/DatabaseBench.cpp Database.cpp Logger.cpp -lsqlite3
+    g++ -std=c++17 $CXXFLAGS -pthread -I. -o ../benchmarks/ReconnectBench \
+        ../benchmarks/ReconnectBench.cpp Protocol.cpp
+    g++ -std=c++17 $CXXFLAGS -pthread -I. -o ../benchmarks/LoadGen \
+        ../benchmarks/LoadGen.cpp Protocol.cpp
+    g++ -std=c++17 $CXXFLAGS -pthread -I. -o ../benchmarks/MicroBench \
+        ../benchmarks/MicroBench.cpp $SERVER_SOURCES -lsqlite3
+fi
+
+# "./build.sh microbench [filter]" builds them and runs the microbenchmarks
+if [ "$1" = "microbench" ]; then
+    echo
+    echo "[microbench] Running hot-path microbenchmarks..."
+    ../benchmarks/MicroBench "$2"
+fi
+
+echo
+echo "========================================"
+echo "BUILD SUCCESSFUL!"
+echo "========================================"
+echo "Executable: CHAT_APPLICATION_SERVER/ChatServer"